@@ -21,6 +21,35 @@
 #define MAX_STACK_SIZE 0x4000
 #define MIN_STACK_SIZE 0x200
 
+#define STACK_PAINT 1                   // Fill new stacks with STACK_PAINT_PATTERN to measure usage
+#define STACK_PAINT_PATTERN 0xA5A5A5A5
+#define STACK_WARN_MARGIN 0x80          // Flag tasks with less than this many bytes never touched
+#define STACK_CHECK_PERIOD 100          // ms between stack checks done by the null task
+
+#define STACK_GUARD 1                   // No-access MPU region at the bottom of the running task's stack
+#define STACK_GUARD_SIZE 32             // Bytes, power of two >= 32 (MPU minimum)
+
+#define TIMER_WHEEL_SIZE 64             // Software timer wheel slots, power of two
+#define TIMER_DAEMON_DEADLINE 5         // ms, deadline of the task running timer callbacks
+#define TIMER_DAEMON_STACK 0x400
+
+#define WORKQ_STACK 0x400               // Stack of the deferred work queue task
+
+#define JOB_STACK_SIZE 0x800            // Stack shared by all run-to-completion jobs (osCreateJob)
+
+#define ADMIT_BOUND_PERCENT 100         // Total density (budget / deadline) admitted, see k_sched_analysis.h
+
+#define LOG_ASYNC 1                     // printf through a ring drained by USART2 TX DMA
+#define LOG_BUF_SIZE 1024               // Bytes, power of two
+
+#define TRACE_ENABLE 0                  // Kernel event trace hooks (k_trace.h), compiled out when 0
+#define TRACE_RECORDS 512               // Trace ring entries of 8 bytes, power of two
+
+#define IDLE_MODE IDLE_WFI              // Default null task behaviour, see k_idle.h
+#define IDLE_STOP_MIN_MS 5              // Shorter idle periods use WFI instead of STOP
+#define IDLE_STOP_MAX_MS 30000          // Longest STOP period (RTC wakeup timer range)
+#define IDLE_HOOKS_MAX 4
+
 #define RTX_ERR 1
 #define RTX_OK 0
 
@@ -58,9 +87,37 @@ typedef enum {
     DORMANT 	= 0,	//state of terminated task
     READY 		= 1,  	//state of task that can be scheduled but is not running
     RUNNING 	= 2,  	//state of running task
-    SLEEPING 	= 3  	//state of sleeping task
+    SLEEPING 	= 3,  	//state of sleeping task
+    BLOCKED 	= 4  	//state of task waiting on a wait queue (mutex, ...)
 } state_t;
 
+typedef enum {
+    JOB_NONE 	= 0,	//ordinary task
+    JOB_RELEASED = 1,	//job that starts from its entry the next time it runs
+    JOB_STARTED = 2 	//job with a frame on the shared stack
+} job_state_t;
+
+typedef struct {
+    uint32_t period;        // ms between releases, 0 for a task that is not periodic
+    uint32_t next_release;  // k_ticks of the next release
+    uint32_t release_tick;  // k_ticks of the current job's release
+    uint32_t release_cycles;// DWT->CYCCNT of the current job's release
+    uint8_t started;        // The current job has run since its release
+    uint32_t jobs;          // Jobs completed
+    uint32_t misses;        // Jobs completed after their deadline
+    uint32_t response_last; // Cycles from release to completion of the last job
+    uint32_t response_max;
+    uint32_t jitter_max;    // Most cycles from a release to the job first running
+} k_period_t;
+
+struct task_control_block;
+struct k_mutex;
+
+typedef struct wait_queue {
+    struct task_control_block* head;    // Blocked tasks, kept in EDF order (time_left, then TID)
+    struct k_mutex* mutex;              // Mutex owning this queue, NULL for other objects
+} wait_queue_t;
+
 typedef struct task_control_block {
     void (*ptask)(void* args); //entry address
     uint16_t stack_size; //stack size. Must be a multiple of 8
@@ -74,6 +131,22 @@ typedef struct task_control_block {
     uint32_t deadline; // how much time was scheduled (in ms)
     uint32_t time_left; // how much time from deadline been used (in ms)
     uint32_t sleep_time;
+
+    uint64_t cpu_cycles; // CPU cycles spent running this task (DWT)
+
+    struct task_control_block* next_waiter; // Next task in the same wait queue
+    wait_queue_t* wait_q;   // Queue the task is BLOCKED on, sleep_time is the timeout (0 = none)
+    int wait_result;        // RTX_OK, or RTX_ERR if the wait failed
+    uint32_t inherit_delta; // time_left given up to deadline inheritance
+    struct k_mutex* held;   // Mutexes held by the task, most recent first
+    void* wait_msg;         // Message pointer being sent/received while BLOCKED on a queue
+    uint32_t wait_flags;    // Event flags waited for, then the flags that released the task
+    uint32_t wait_opts;     // OS_EVENT_* options of the wait
+    uint8_t static_stack;   // Stack supplied by osCreateTaskStatic, never freed by the kernel
+    uint8_t job;            // JOB_* state, JOB_NONE for a task with its own stack
+    struct task_control_block* job_below; // Job this one was started on top of, on the shared stack
+    k_period_t periodic;    // Release times and job statistics of a periodic task or job
+    uint32_t budget;        // Worst-case ms of CPU per job, 0 for a task outside admission control
 }  TCB;
 
 extern uint8_t kernel_init;
@@ -0,0 +1,68 @@
+/*
+ * k_idle.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Idle-time power management, run by the null task. Registered idle hooks
+ *      run first, then the core sleeps according to the idle mode:
+ *
+ *      IDLE_RUN   spin, as before
+ *      IDLE_WFI   sleep until the next interrupt; SysTick still wakes it every ms
+ *      IDLE_STOP  tickless: when nothing is due for at least IDLE_STOP_MIN_MS,
+ *                 stop SysTick and enter STOP mode until the RTC wakeup timer
+ *                 (clocked by the LSI) fires at the next task timeout or timer
+ *                 expiry, then restore the PLL and catch the kernel tick up by
+ *                 the time the RTC measured. Shorter idle periods use WFI.
+ *
+ *      The LSI is only specified to 17-47 kHz. Before the first STOP after
+ *      osIdleSetMode(IDLE_STOP) the null task spends ~100 ms of idle time
+ *      measuring it against the core clock (idle_lsi_hz), and the wakeup
+ *      interval and the slept time are scaled by that. What remains is the LSI's
+ *      drift since the measurement (temperature, supply); set IDLE_STOP again to
+ *      re-measure. The accuracy of SystemCoreClock (HSI, 1%) bounds the result.
+ *
+ *      The cycles spent asleep are added to the null task, so osGetCpuLoad
+ *      stays correct even though the DWT cycle counter stops in sleep.
+ */
+#include <stdint.h>
+#include "common.h"
+
+#ifndef INC_K_IDLE_H_
+#define INC_K_IDLE_H_
+
+#define IDLE_RUN 0
+#define IDLE_WFI 1
+#define IDLE_STOP 2
+
+extern volatile uint32_t idle_wake_stamp; // DWT cycle count when the core last left WFI/STOP
+extern uint32_t idle_lsi_hz;              // Measured LSI frequency, nominal 32000 until IDLE_STOP is used
+
+/**
+ * @brief One pass of the idle loop: run the hooks, then sleep. Called by null_task.
+ */
+void k_idle(void);
+
+/**
+ * @brief Advance the kernel tick (HAL tick, task timeouts, timer wheel) after a tickless sleep.
+ *        Ticks before the next task timeout or timer expiry are skipped in one step.
+ * @param ms Milliseconds that passed without SysTick
+ */
+void k_idle_compensate(uint32_t ms);
+
+/**
+ * @brief Select how the null task idles. IDLE_STOP also has the LSI measured
+ *        again before the next STOP.
+ * @param mode IDLE_RUN, IDLE_WFI or IDLE_STOP
+ * @return int RTX_OK on success, RTX_ERR for an unknown mode
+ */
+int osIdleSetMode(int mode);
+
+/**
+ * @brief Register a function the null task runs before every sleep. Hooks run
+ *        in thread mode at the lowest priority and must not block.
+ * @param hook The function
+ * @return int RTX_OK on success, RTX_ERR if IDLE_HOOKS_MAX hooks are registered
+ */
+int osIdleHookAdd(void (*hook)(void));
+
+#endif /* INC_K_IDLE_H_ */
@@ -0,0 +1,46 @@
+/*
+ * k_log.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Binary deferred logging. KLOG stores the format string in .klog_fmt,
+ *      a non-loaded (INFO) section of the ELF, and at run time only writes
+ *      a record into the printf/DMA log ring:
+ *
+ *          word 0: fmt offset << 16 | nargs << 8 | KLOG_SYNC
+ *          word 1: DWT->CYCCNT
+ *          word 2..: the arguments as 32-bit words
+ *
+ *      Formatting happens on the host with Tools/klog_decode.py, which reads
+ *      the strings back from the ELF. Arguments must be 32-bit integers
+ *      (%d %u %x %c, cast pointers to uint32_t for %p); %s and floats are not
+ *      supported. Records and ordinary printf text share the UART: ASCII never
+ *      contains KLOG_SYNC, so the decoder passes text through unchanged.
+ *      A record that does not fit in the ring is dropped whole and counted in
+ *      log_dropped_count().
+ */
+#include <stdint.h>
+#include "common.h"
+
+#ifndef INC_K_LOG_H_
+#define INC_K_LOG_H_
+
+#define KLOG_SYNC 0xA5
+#define KLOG_MAX_ARGS 6
+
+#define KLOG(fmt, ...) do { \
+	static const char klog_fmt_[] __attribute__((section(".klog_fmt"), used)) = fmt; \
+	const uint32_t klog_args_[] = { 0, ##__VA_ARGS__ }; \
+	_Static_assert(sizeof(klog_args_) / sizeof(uint32_t) - 1 <= KLOG_MAX_ARGS, "too many KLOG arguments"); \
+	klog_write(klog_fmt_, klog_args_ + 1, sizeof(klog_args_) / sizeof(uint32_t) - 1); \
+} while (0)
+
+/**
+ * @brief Write one binary log record, use the KLOG macro instead
+ * @param fmt Format string placed in .klog_fmt (its address is the offset in the section)
+ * @param args Arguments
+ * @param nargs Number of arguments, at most KLOG_MAX_ARGS
+ */
+void klog_write(const char* fmt, const uint32_t* args, uint32_t nargs);
+
+#endif /* INC_K_LOG_H_ */
@@ -12,8 +12,8 @@
 #ifndef INC_K_MEM_H_
 #define INC_K_MEM_H_
 
-#define HEAP_START (uint32_t) &_img_end
-#define HEAP_END ((uint32_t) &_estack - 0x4000)
+#define HEAP_START (uint32_t)(uintptr_t)&_img_end
+#define HEAP_END ((uint32_t)(uintptr_t)&_estack - 0x4000)
 #define HEAP_SIZE HEAP_END - HEAP_START 
 
 #define MIN_BLOCK_SIZE 4
@@ -48,6 +48,13 @@ void* k_mem_alloc(size_t size);
  */
 int k_mem_dealloc(void* ptr);
 
+/**
+ * @brief Find the metadata of an allocated block in O(1) from its data pointer
+ * @param ptr Pointer returned by k_mem_alloc
+ * @return heap_block_t* The block, or NULL if ptr is not the start of an allocated block
+ */
+heap_block_t* k_mem_block(void* ptr);
+
 /**
  * @brief Count the number of free memory regions strictly less than size
  * @param size The size of the blocks
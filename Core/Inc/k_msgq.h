@@ -0,0 +1,86 @@
+/*
+ * k_msgq.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Zero-copy message queues. Messages are pointers to k_mem buffers and
+ *      ownership of the buffer moves with the message: the sender gives it up
+ *      on send and the receiver owns it (and must k_mem_dealloc or forward it)
+ *      after receive.
+ */
+#include <stdio.h>
+#include "common.h"
+#include "k_sync.h"
+
+#ifndef INC_K_MSGQ_H_
+#define INC_K_MSGQ_H_
+
+typedef struct k_msgq {
+    void** buf;             // Ring of message pointers, from one k_mem_alloc
+    uint32_t capacity;      // Number of slots in buf
+    uint32_t head;          // Next slot to receive from
+    uint32_t count;         // Messages currently queued
+    wait_queue_t senders;   // Tasks blocked on a full queue
+    wait_queue_t receivers; // Tasks blocked on an empty queue
+} k_msgq_t;
+
+/**
+ * @brief SVC side of osMsgQueueSend
+ * @param q The queue
+ * @param msg The message buffer, owned by the caller
+ * @param timeout Timeout in ms, 0 to fail when full, or OS_WAIT_FOREVER
+ */
+void k_msgq_send(k_msgq_t* q, void* msg, uint32_t timeout);
+
+/**
+ * @brief SVC side of osMsgQueueReceive, the message is returned in current_task->wait_msg
+ * @param q The queue
+ * @param timeout Timeout in ms, 0 to fail when empty, or OS_WAIT_FOREVER
+ */
+void k_msgq_receive(k_msgq_t* q, uint32_t timeout);
+
+/**
+ * @brief Create a message queue, allocating its ring with a single k_mem_alloc
+ * @param q The queue
+ * @param capacity Maximum number of queued messages
+ * @return int RTX_OK on success, RTX_ERR if the ring could not be allocated
+ */
+int osMsgQueueCreate(k_msgq_t* q, uint32_t capacity);
+
+/**
+ * @brief Free the ring of an empty queue. Must be called by the task that created it.
+ * @param q The queue
+ * @return int RTX_OK on success, RTX_ERR if messages or tasks are still waiting
+ */
+int osMsgQueueDelete(k_msgq_t* q);
+
+/**
+ * @brief Send a message, blocking while the queue is full. A waiting receiver
+ *        gets the message directly, the earliest deadline receiver first.
+ * @param q The queue
+ * @param msg Buffer from k_mem_alloc owned by the caller. Ownership passes to
+ *        the queue on success and stays with the caller on failure.
+ * @param timeout Time to wait in ms: 0 never blocks, OS_WAIT_FOREVER never times out
+ * @return int RTX_OK on success, RTX_ERR on timeout or if the caller does not own msg
+ */
+int osMsgQueueSend(k_msgq_t* q, void* msg, uint32_t timeout);
+
+/**
+ * @brief Receive a message, blocking while the queue is empty
+ * @param q The queue
+ * @param msg Destination of the message pointer, owned by the caller afterwards
+ * @param timeout Time to wait in ms: 0 never blocks, OS_WAIT_FOREVER never times out
+ * @return int RTX_OK on success, RTX_ERR on timeout
+ */
+int osMsgQueueReceive(k_msgq_t* q, void** msg, uint32_t timeout);
+
+/**
+ * @brief Send a message from an interrupt handler without blocking. The ISR
+ *        must be masked by KERNEL_CEILING; the call runs in a kernel critical section.
+ * @param q The queue
+ * @param msg Buffer from k_mem_alloc, ownership passes to the queue
+ * @return int RTX_OK on success, RTX_ERR if the queue is full
+ */
+int osMsgQueueSendFromISR(k_msgq_t* q, void* msg);
+
+#endif /* INC_K_MSGQ_H_ */
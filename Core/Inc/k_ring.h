@@ -0,0 +1,155 @@
+/*
+ * k_ring.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Lock-free single-producer/single-consumer ring buffer of 32-bit words,
+ *      meant for streaming samples from one ISR to one task without any
+ *      critical section. Header only.
+ *
+ *      head and tail are free-running counters, each written by one side only.
+ *      The index into buf is counter & mask, so the capacity must be a power
+ *      of two and the ring holds exactly capacity items. The acquire/release
+ *      accesses compile to LDR/STR plus DMB on the Cortex-M4, which orders the
+ *      data write before the index update as seen by the other side.
+ *
+ *      Define K_RING_NOTIFY to 0 to build without the kernel (e.g. host tests).
+ */
+#include <stdint.h>
+
+#ifndef K_RING_NOTIFY
+#define K_RING_NOTIFY 1
+#endif
+
+#if K_RING_NOTIFY
+#include "k_sync.h"
+#endif
+
+#ifndef INC_K_RING_H_
+#define INC_K_RING_H_
+
+typedef struct k_ring {
+    uint32_t* buf;          // Storage, capacity words
+    uint32_t mask;          // capacity - 1
+    uint32_t head;          // Items ever put, written by the producer only
+    uint32_t tail;          // Items ever taken, written by the consumer only
+#if K_RING_NOTIFY
+    k_sem_t* notify;        // Given on the empty -> non-empty transition, or NULL
+#endif
+} k_ring_t;
+
+// Static storage for a ring, capacity must be a power of two
+#define K_RING_DEFINE(name, capacity) \
+	_Static_assert(((capacity) & ((capacity) - 1)) == 0, "k_ring capacity must be a power of two"); \
+	static uint32_t name##_buf[(capacity)]; \
+	static k_ring_t name = { .buf = name##_buf, .mask = (capacity) - 1 }
+
+/**
+ * @brief Initialize a ring over caller-provided storage
+ * @param ring The ring
+ * @param buf Storage of capacity words
+ * @param capacity Number of words, must be a power of two
+ */
+static inline void k_ring_init(k_ring_t* ring, uint32_t* buf, uint32_t capacity)
+{
+	ring->buf = buf;
+	ring->mask = capacity - 1;
+	ring->head = 0;
+	ring->tail = 0;
+#if K_RING_NOTIFY
+	ring->notify = NULL;
+#endif
+}
+
+/**
+ * @brief Number of items in the ring, exact for either side
+ * @param ring The ring
+ * @return uint32_t Items available to the consumer
+ */
+static inline uint32_t k_ring_count(k_ring_t* ring)
+{
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Producer side: append one item
+ * @param ring The ring
+ * @param item The item
+ * @return int 1 on success, 0 if the ring is full
+ */
+static inline int k_ring_put(k_ring_t* ring, uint32_t item)
+{
+	uint32_t head = ring->head; // only we write head
+	if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > ring->mask) {
+		return 0;
+	}
+	ring->buf[head & ring->mask] = item;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE); // publish after the data
+	return 1;
+}
+
+/**
+ * @brief Consumer side: remove the oldest item
+ * @param ring The ring
+ * @param item Destination of the item
+ * @return int 1 on success, 0 if the ring is empty
+ */
+static inline int k_ring_get(k_ring_t* ring, uint32_t* item)
+{
+	uint32_t tail = ring->tail; // only we write tail
+	if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+		return 0;
+	}
+	*item = ring->buf[tail & ring->mask];
+	__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE); // free the slot after reading it
+	return 1;
+}
+
+#if K_RING_NOTIFY
+/**
+ * @brief Producer side from an ISR: append one item and give ring->notify only
+ *        if the ring was empty, so a busy consumer costs no kernel call per item.
+ *        The ISR must run at KERNEL_IRQ_PRIORITY.
+ * @param ring The ring
+ * @param item The item
+ * @return int 1 on success, 0 if the ring is full
+ */
+static inline int k_ring_put_notify(k_ring_t* ring, uint32_t item)
+{
+	uint32_t head = ring->head;
+	if (!k_ring_put(ring, item)) {
+		return 0;
+	}
+	// Full fence: the consumer stores tail then loads head, we store head then load tail
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == head && ring->notify) {
+		osSemaphoreGiveFromISR(ring->notify);
+	}
+	return 1;
+}
+
+/**
+ * @brief Consumer side from a task: take the oldest item, blocking on ring->notify
+ *        while the ring is empty
+ * @param ring The ring
+ * @param item Destination of the item
+ * @param timeout Time to wait in ms, or OS_WAIT_FOREVER
+ * @return int RTX_OK if an item was taken, RTX_ERR on timeout
+ */
+static inline int k_ring_get_wait(k_ring_t* ring, uint32_t* item, uint32_t timeout)
+{
+	while (!k_ring_get(ring, item)) {
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (k_ring_count(ring)) {
+			continue;
+		}
+		// Stale notifications only cause an extra pass through the loop
+		if (osSemaphoreTake(ring->notify, timeout) != RTX_OK) {
+			return RTX_ERR;
+		}
+	}
+	return RTX_OK;
+}
+#endif
+
+#endif /* INC_K_RING_H_ */
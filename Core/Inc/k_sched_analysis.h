@@ -0,0 +1,83 @@
+/*
+ * k_sched_analysis.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Schedulability of deadline tasks under EDF.
+ *
+ *      Admission control: a task created with a budget (worst-case execution
+ *      time per job) claims a density of budget / deadline. The kernel keeps
+ *      the sum and refuses creations and deadline changes that would push it
+ *      above ADMIT_BOUND_PERCENT. With deadlines equal to periods the density
+ *      is the utilization and a bound of 100% is exact; with shorter deadlines
+ *      it is sufficient but pessimistic.
+ *
+ *      Processor-demand analysis is the exact test for constrained deadlines
+ *      (deadline <= period). It has no kernel dependencies, so it can check a
+ *      task set offline on a PC (Tests/host/sched_analysis_host_test.c) as
+ *      well as at run time.
+ */
+#include <stdint.h>
+#include "common.h"
+
+#ifndef INC_K_SCHED_ANALYSIS_H_
+#define INC_K_SCHED_ANALYSIS_H_
+
+#define DENSITY_ONE (1U << 16)      // Density of a task that needs the whole CPU, Q16
+
+typedef struct {
+    uint32_t budget;    // C, worst-case execution time per job
+    uint32_t deadline;  // D, relative deadline, 0 < D <= T
+    uint32_t period;    // T, minimum time between releases
+} k_task_param_t;
+
+/**
+ * @brief Density of a task, budget / deadline in Q16, rounded up so admission errs
+ *        on the safe side (a set filling the bound exactly may be refused unless
+ *        its densities are multiples of 1 / 65536)
+ * @return uint32_t 0 for a task without budget, UINT32_MAX if deadline is 0
+ */
+uint32_t k_density(uint32_t budget, uint32_t deadline);
+
+/**
+ * @brief Forget all admitted tasks, called by osKernelInit
+ */
+void k_admit_init(void);
+
+/**
+ * @brief Replace one density in the kernel's total, if the result stays within
+ *        ADMIT_BOUND_PERCENT. Called from kernel context only.
+ * @param remove Density given up (0 for a new task)
+ * @param add Density requested (0 for an exiting task)
+ * @return int RTX_OK if the total was updated, RTX_ERR if it would exceed the bound
+ */
+int k_admit(uint32_t remove, uint32_t add);
+
+/**
+ * @brief Total density of the admitted tasks
+ * @return uint32_t Q16, DENSITY_ONE is 100%
+ */
+uint32_t k_density_total(void);
+
+/**
+ * @brief Utilization test, sum of budget / period at most 1. Exact for implicit
+ *        deadlines (D = T), necessary but not sufficient for constrained ones.
+ * @param tasks The task set
+ * @param n Number of tasks
+ * @return int RTX_OK if the utilization is at most 1, RTX_ERR otherwise
+ */
+int k_sched_utilization_test(const k_task_param_t* tasks, int n);
+
+/**
+ * @brief Processor-demand test: for every absolute deadline t in the first
+ *        synchronous busy period, the demand bound
+ *        dbf(t) = sum over tasks with D <= t of (floor((t - D) / T) + 1) * C
+ *        must not exceed t.
+ * @param tasks The task set, deadlines at most periods
+ * @param n Number of tasks
+ * @param miss_at If not NULL, receives the first t where dbf(t) > t (0 on success)
+ * @return int RTX_OK if EDF meets every deadline, RTX_ERR otherwise
+ */
+int k_sched_demand_test(const k_task_param_t* tasks, int n, uint32_t* miss_at);
+
+#endif /* INC_K_SCHED_ANALYSIS_H_ */
@@ -0,0 +1,247 @@
+/*
+ * k_sync.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Kernel synchronization primitives. Blocked tasks wait on a wait_queue_t
+ *      kept in EDF order, so the earliest deadline waiter is always released first.
+ */
+#include <stdio.h>
+#include "common.h"
+
+#ifndef INC_K_SYNC_H_
+#define INC_K_SYNC_H_
+
+typedef struct k_sem {
+    volatile uint32_t count;    // Available units (LDREX/STREX target)
+    wait_queue_t waiters;       // Tasks blocked in osSemaphoreTake
+} k_sem_t;
+
+#define OS_EVENT_WAIT_ANY 0x0     // Release when any of the requested flags is set
+#define OS_EVENT_WAIT_ALL 0x1     // Release when all of the requested flags are set
+#define OS_EVENT_AUTO_CLEAR 0x2   // Clear the requested flags when the wait is satisfied
+
+typedef struct k_event {
+    volatile uint32_t flags;    // Current flags (LDREX/STREX target)
+    wait_queue_t waiters;       // Tasks blocked in osEventWait
+} k_event_t;
+
+typedef struct k_mutex {
+    volatile uint32_t owner;    // TCB* of the holder, 0 when free (LDREX/STREX target)
+    wait_queue_t waiters;       // Tasks blocked in osMutexLock
+    struct k_mutex* next_held;  // Next mutex held by the same owner
+} k_mutex_t;
+
+/***********************************************************************************************
+ * WAIT QUEUES (kernel only, called from SVC/SysTick context)
+ ***********************************************************************************************/
+
+/**
+ * @brief Insert a task into a wait queue in EDF order
+ * @param q The wait queue
+ * @param task The task to insert
+ */
+void wait_insert(wait_queue_t* q, TCB* task);
+
+/**
+ * @brief Remove a task from the wait queue it is blocked on
+ * @param task The task to remove
+ */
+void wait_remove(TCB* task);
+
+/**
+ * @brief Block the running task on a wait queue and request a context switch
+ * @param q The wait queue
+ * @param timeout Ticks before tick_time_left releases the task with RTX_ERR, or OS_WAIT_FOREVER
+ */
+void wait_block(wait_queue_t* q, uint32_t timeout);
+
+/**
+ * @brief Release a specific task from the wait queue it is blocked on
+ * @param task The blocked task
+ * @param result Value the task gets back from its blocking call
+ */
+void wait_wake(TCB* task, int result);
+
+/**
+ * @brief Release the earliest deadline waiter of a queue
+ * @param q The wait queue
+ * @param result Value the waiter gets back from its blocking call
+ * @return TCB* The released task, or NULL if nobody was waiting
+ */
+TCB* wait_wake_one(wait_queue_t* q, int result);
+
+/**
+ * @brief Raise a task's priority to a waiter's deadline, following chains of
+ *        tasks blocked on other mutexes
+ * @param owner Mutex holder
+ * @param time_left time_left of the waiter
+ */
+void inherit_deadline(TCB* owner, uint32_t time_left);
+
+/**
+ * @brief Forget what a task inherited and take again the deadline of the earliest
+ *        waiter on each mutex it holds. Used when its own time_left is renewed
+ *        (woken from a sleep, yield, new deadline); a READY task must be queued.
+ * @param task The task
+ */
+void reinherit_deadline(TCB* task);
+
+/**
+ * @brief SVC side of osMutexLock, called when the fast path found the mutex taken
+ * @param mutex The mutex
+ */
+void k_mutex_lock(k_mutex_t* mutex);
+
+/**
+ * @brief SVC side of osMutexUnlock, hands the mutex to the earliest deadline waiter
+ *        and drops any deadline the caller inherited through it
+ * @param mutex The mutex
+ */
+void k_mutex_unlock(k_mutex_t* mutex);
+
+/**
+ * @brief Release every mutex a task still holds, handing each to its earliest
+ *        deadline waiter as k_mutex_unlock does. Called when the task exits.
+ * @param task The task
+ */
+void k_mutex_release_all(TCB* task);
+
+/**
+ * @brief SVC side of osSemaphoreTake, blocks the caller if no unit is available
+ * @param sem The semaphore
+ * @param timeout Timeout in ms, or OS_WAIT_FOREVER
+ */
+void k_sem_take(k_sem_t* sem, uint32_t timeout);
+
+/**
+ * @brief Give a semaphore unit, handing it straight to the earliest deadline
+ *        waiter if there is one. Shared by the SVC and ISR paths.
+ * @param sem The semaphore
+ */
+void k_sem_give(k_sem_t* sem);
+
+/**
+ * @brief Set event flags and release, in one pass in deadline order, every
+ *        waiter whose condition is now met. Shared by the SVC and ISR paths.
+ * @param event The event group
+ * @param flags Flags to set
+ */
+void k_event_set(k_event_t* event, uint32_t flags);
+
+/**
+ * @brief SVC side of osEventWait, the result is returned in current_task->wait_flags
+ * @param event The event group
+ * @param flags Flags to wait for
+ * @param options OS_EVENT_WAIT_ANY or OS_EVENT_WAIT_ALL, optionally | OS_EVENT_AUTO_CLEAR
+ * @param timeout Timeout in ms, 0 to fail immediately, or OS_WAIT_FOREVER
+ */
+void k_event_wait(k_event_t* event, uint32_t flags, uint32_t options, uint32_t timeout);
+
+/***********************************************************************************************
+ * SEMAPHORE API
+ ***********************************************************************************************/
+
+/**
+ * @brief Initialize a counting semaphore
+ * @param sem The semaphore
+ * @param count Initial number of units
+ */
+void osSemaphoreInit(k_sem_t* sem, uint32_t count);
+
+/**
+ * @brief Take a unit from a semaphore. Takes without waiting do not enter the kernel.
+ * @param sem The semaphore
+ * @param timeout Time to wait in ms: 0 never blocks, OS_WAIT_FOREVER never times out
+ * @return int RTX_OK if a unit was taken, RTX_ERR on timeout
+ */
+int osSemaphoreTake(k_sem_t* sem, uint32_t timeout);
+
+/**
+ * @brief Give a unit to a semaphore from a task
+ * @param sem The semaphore
+ * @return int RTX_OK
+ */
+int osSemaphoreGive(k_sem_t* sem);
+
+/**
+ * @brief Give a unit to a semaphore from an interrupt handler. A waiting task is
+ *        moved to the ready queue directly and PendSV is only pended if its
+ *        deadline beats the interrupted task. The ISR must be masked by
+ *        KERNEL_CEILING; the call runs in a kernel critical section.
+ * @param sem The semaphore
+ */
+void osSemaphoreGiveFromISR(k_sem_t* sem);
+
+/***********************************************************************************************
+ * EVENT FLAGS API
+ ***********************************************************************************************/
+
+/**
+ * @brief Initialize an event group with all 32 flags clear
+ * @param event The event group
+ */
+void osEventInit(k_event_t* event);
+
+/**
+ * @brief Set flags from a task. Does not enter the kernel if nobody is waiting.
+ * @param event The event group
+ * @param flags Flags to set
+ * @return uint32_t The flags after the set (and after any auto-clear by released waiters)
+ */
+uint32_t osEventSet(k_event_t* event, uint32_t flags);
+
+/**
+ * @brief Set flags from an interrupt handler masked by KERNEL_CEILING, in a
+ *        kernel critical section
+ * @param event The event group
+ * @param flags Flags to set
+ */
+void osEventSetFromISR(k_event_t* event, uint32_t flags);
+
+/**
+ * @brief Clear flags, from a task or an ISR. Never enters the kernel.
+ * @param event The event group
+ * @param flags Flags to clear
+ * @return uint32_t The flags before clearing
+ */
+uint32_t osEventClear(k_event_t* event, uint32_t flags);
+
+/**
+ * @brief Wait until any or all of the given flags are set
+ * @param event The event group
+ * @param flags Flags to wait for
+ * @param options OS_EVENT_WAIT_ANY or OS_EVENT_WAIT_ALL, optionally | OS_EVENT_AUTO_CLEAR
+ * @param timeout Time to wait in ms: 0 never blocks, OS_WAIT_FOREVER never times out
+ * @param result Destination of the event flags that satisfied the wait, may be NULL
+ * @return int RTX_OK if the condition was met, RTX_ERR on timeout
+ */
+int osEventWait(k_event_t* event, uint32_t flags, uint32_t options, uint32_t timeout, uint32_t* result);
+
+/***********************************************************************************************
+ * MUTEX API
+ ***********************************************************************************************/
+
+/**
+ * @brief Initialize a mutex in the unlocked state
+ * @param mutex The mutex
+ */
+void osMutexInit(k_mutex_t* mutex);
+
+/**
+ * @brief Lock a mutex, blocking if another task holds it. While blocked, the holder
+ *        inherits the caller's deadline if it is earlier than its own.
+ *        An uncontended lock is a single LDREX/STREX and does not enter the kernel.
+ * @param mutex The mutex
+ * @return int RTX_OK once the mutex is held, RTX_ERR if the caller already holds it
+ */
+int osMutexLock(k_mutex_t* mutex);
+
+/**
+ * @brief Unlock a mutex held by the calling task
+ * @param mutex The mutex
+ * @return int RTX_OK on success, RTX_ERR if the caller does not hold the mutex
+ */
+int osMutexUnlock(k_mutex_t* mutex);
+
+#endif /* INC_K_SYNC_H_ */
@@ -8,28 +8,107 @@
  */
 
 #include <stdio.h>
+#include "main.h"
 #include "common.h"
 
 #ifndef INC_K_TASK_H_
 #define INC_K_TASK_H_
 
+#define SVC_PING 0
 #define SVC_KERNEL_START 1
 #define SVC_KERNEL_YIELD 2
 #define SVC_KERNEL_EXIT  3
 #define SVC_TASK_CREATE 5
 #define SVC_KERNEL_OS_SLEEP 6
+#define SVC_MUTEX_LOCK 7
+#define SVC_MUTEX_UNLOCK 8
+#define SVC_SEM_TAKE 9
+#define SVC_SEM_GIVE 10
+#define SVC_MSGQ_SEND 11
+#define SVC_MSGQ_RECEIVE 12
+#define SVC_EVENT_SET 13
+#define SVC_EVENT_WAIT 14
+#define SVC_JOB_CREATE 15
+#define SVC_JOB_DONE 16
+#define SVC_PERIODIC_CREATE 17
+#define SVC_PERIOD_WAIT 18
+#define SVC_COUNT 19            // Size of the dispatch table in k_task.c
+
+#define OS_WAIT_FOREVER 0xFFFFFFFF  // Timeout value for blocking calls that never time out
+#define KERNEL_IRQ_PRIORITY 15      // NVIC priority for ISRs that call *FromISR functions (same as SysTick).
+                                    // Any value from KERNEL_CEILING to 15 works: the calls mask SysTick
+                                    // and each other with a kernel critical section
+#define KERNEL_CEILING 13           // NVIC priority of SVC and the kernel critical-section BASEPRI.
+                                    // Interrupts with a lower number are never masked by the kernel
+                                    // but must not call kernel functions.
+
+_Static_assert(KERNEL_CEILING >= 1 && KERNEL_CEILING <= 13, "SVC must stay above PendSV (14) and SysTick (15)");
+_Static_assert(KERNEL_IRQ_PRIORITY >= KERNEL_CEILING, "kernel-aware ISRs must be masked by the ceiling");
+
+#ifdef K_PORT_HOST
+// Linux port (Host/): system calls and the priority registers are emulated
+#include "k_port_host.h"
+#else
 
 #define SHPR2 (*((volatile uint32_t*)0xE000ED1C))//SVC is bits 31-28
 #define SHPR3 (*((volatile uint32_t*)0xE000ED20))//SysTick is bits 31-28, and PendSV is bits 23-20
 
 #define __set_pendsv() SCB->ICSR = 0x10000000
 
-extern uint8_t SVC_RET;
-extern TCB* new_task;
+// Issue an SVC without arguments, evaluates to the r0 the handler left in svc_args[0]
+#define __svc(svc_number) ({ \
+	register uint32_t __r0 __asm("r0"); \
+	__asm volatile("SVC %1" : "=r"(__r0) : "i"(svc_number) : "memory"); \
+	__r0; \
+})
+
+// Issue an SVC with one argument in r0, read as svc_args[0] by the handler, evaluates to r0 on return
+#define __svc_arg(svc_number, arg) ({ \
+	register uint32_t __r0 __asm("r0") = (uint32_t)(arg); \
+	__asm volatile("SVC %1" : "+r"(__r0) : "i"(svc_number) : "memory"); \
+	__r0; \
+})
+
+// Same with a second argument in r1 (svc_args[1])
+#define __svc_arg2(svc_number, arg0, arg1) ({ \
+	register uint32_t __r0 __asm("r0") = (uint32_t)(arg0); \
+	register uint32_t __r1 __asm("r1") = (uint32_t)(arg1); \
+	__asm volatile("SVC %2" : "+r"(__r0) : "r"(__r1), "i"(svc_number) : "memory"); \
+	__r0; \
+})
+
+// Same with a third argument in r2 (svc_args[2])
+#define __svc_arg3(svc_number, arg0, arg1, arg2) ({ \
+	register uint32_t __r0 __asm("r0") = (uint32_t)(arg0); \
+	register uint32_t __r1 __asm("r1") = (uint32_t)(arg1); \
+	register uint32_t __r2 __asm("r2") = (uint32_t)(arg2); \
+	__asm volatile("SVC %3" : "+r"(__r0) : "r"(__r1), "r"(__r2), "i"(svc_number) : "memory"); \
+	__r0; \
+})
+
+// Same with a fourth argument in r3 (svc_args[3])
+#define __svc_arg4(svc_number, arg0, arg1, arg2, arg3) ({ \
+	register uint32_t __r0 __asm("r0") = (uint32_t)(arg0); \
+	register uint32_t __r1 __asm("r1") = (uint32_t)(arg1); \
+	register uint32_t __r2 __asm("r2") = (uint32_t)(arg2); \
+	register uint32_t __r3 __asm("r3") = (uint32_t)(arg3); \
+	__asm volatile("SVC %4" : "+r"(__r0) : "r"(__r1), "r"(__r2), "r"(__r3), "i"(svc_number) : "memory"); \
+	__r0; \
+})
+
+#endif /* K_PORT_HOST */
+
+#define INITIAL_XPSR 0x01000000 // Thumb bit set
+
+extern uint32_t k_ticks;            // Kernel ticks (ms) since osKernelInit
+extern uint32_t cpu_stamp;
+extern uint64_t cpu_total;
+extern uint32_t stack_warn_mask;
+extern const uint32_t kernel_basepri;
 
 /**
- * @brief SVC syscall handler
- * @param svc_args The system call number
+ * @brief SVC syscall handler, dispatches through a constant table indexed by SVC number
+ * @param svc_args Stacked exception frame of the caller (r0-r3 are the arguments)
  */
 void SVC_Handler_Main(unsigned int*);
 
@@ -39,10 +118,17 @@ void SVC_Handler_Main(unsigned int*);
 void __run_first_thread();
 
 /**
- * @brief Context switch to another task
- * @return int RTX_OK if successful and RTX_ERROR otherwise
+ * @brief Pick the next task to run, called from PendSV_Handler before any registers are saved
+ * @return TCB* The task to switch to, or NULL if the running task was re-selected
+ */
+TCB* run_scheduler();
+
+/**
+ * @brief Move the stack guard to the task being switched to, called from PendSV_Handler
+ *        after the outgoing context is saved so that save is still checked by its own guard
+ * @param task The task being switched to
  */
-int run_scheduler();
+void switch_stack_guard(TCB* task);
 
 /**
  * @brief Initialize a task control block
@@ -54,8 +140,22 @@ void init_tcb(size_t idx, TCB *input, int deadline);
 
 /**
  * @brief Initialize a task stack
+ * @param task The task_list entry
+ * @param input Reference TCB, receives stack_bot and stack_high
+ * @param stack Low address of a caller-provided stack, or 0 to allocate one from the heap
+ * @return int RTX_OK on success, RTX_ERR if the heap is exhausted
  */
-int init_t_stack(TCB *task, TCB *input);
+int init_t_stack(TCB *task, TCB *input, uint32_t stack);
+
+/**
+ * @brief Build the initial context frame of a task below stack_high.
+ *        Layout (high to low): xPSR, PC, LR, R12, R3-R0, EXC_RETURN, R11-R4.
+ *        EXC_RETURN is popped by PendSV_Handler and selects whether S16-S31 are restored.
+ * @param stack_high High address of the task stack
+ * @param ptask Task entry point
+ * @return uint32_t The new top of stack to store in the TCB
+ */
+uint32_t init_t_frame(uint32_t stack_high, void (*ptask)(void* args));
 
 /**
  * @brief Insert a task into the queue
@@ -69,14 +169,84 @@ void queue_task(TCB* task);
  */
 TCB* pop_task();
 
+/**
+ * @brief Look at the task pop_task would return without removing it
+ * @return TCB* Earliest deadline task, or the null task if the queue is empty
+ */
+TCB* peek_task();
+
 uint8_t heap_swap_check(TCB* parent, TCB* child);
 
 void update_heap(task_t TID);
 
+/**
+ * @brief Preempt the running task if a task that was just made READY should run first.
+ *        Safe to call several times in one kernel entry.
+ * @param task The task that was just queued
+ */
+void preempt_check(TCB* task);
+
 void tick_time_left();
 
+/**
+ * @brief Advance the kernel by several ticks at which nothing is due, after a
+ *        tickless sleep: only the null task may be ready, and every timeout
+ *        must be longer than ticks
+ * @param ticks Ticks to skip
+ */
+void tick_skip(uint32_t ticks);
+
+/**
+ * @brief Enter a kernel critical section by raising BASEPRI to the kernel ceiling.
+ *        SVC, PendSV, SysTick and kernel-aware ISRs wait until k_crit_exit;
+ *        interrupts above KERNEL_CEILING still run. Sections nest. Do not make
+ *        a system call inside one: the SVC would be masked and escalate to HardFault.
+ * @return uint32_t The previous BASEPRI, to pass to k_crit_exit
+ */
+static inline uint32_t k_crit_enter(void)
+{
+	uint32_t basepri = __get_BASEPRI();
+	__set_BASEPRI_MAX(KERNEL_CEILING << (8 - __NVIC_PRIO_BITS));
+	__ISB();
+	return basepri;
+}
+
+/**
+ * @brief Leave a kernel critical section
+ * @param basepri Value returned by the matching k_crit_enter
+ */
+static inline void k_crit_exit(uint32_t basepri)
+{
+	__set_BASEPRI(basepri);
+}
+
+/**
+ * @brief Charge the cycles since the last accounting point to a task
+ * @param task The task that was running during that interval
+ */
+static inline void account_cycles(TCB* task)
+{
+	uint32_t now = DWT->CYCCNT;
+	uint32_t delta = now - cpu_stamp; // unsigned wrap handles CYCCNT overflow
+	cpu_stamp = now;
+	task->cpu_cycles += delta;
+	cpu_total += delta;
+}
+
 void null_task(void*);
 
+/**
+ * @brief Fill a stack with STACK_PAINT_PATTERN (no-op when STACK_PAINT is 0)
+ * @param stack_bot Low address of the stack
+ * @param stack_size Size of the stack in bytes
+ */
+void paint_stack(uint32_t stack_bot, uint32_t stack_size);
+
+/**
+ * @brief Flag tasks whose stack headroom is below STACK_WARN_MARGIN, run from the null task
+ */
+void check_stacks(void);
+
 /**
  * @brief Initializes all global kernel-level data structures and other variables.
  *        This function must be called before any other RTX functions will work
@@ -121,7 +291,8 @@ int osTaskInfo(task_t TID, TCB* task_copy);
 task_t osGetTID(void);
 
 /**
- * @brief Exit task and anything being used is returned to OS
+ * @brief Exit task and anything being used is returned to OS. Mutexes it still
+ *        holds pass to their first waiter, as if unlocked.
  * @return int Nothing if successful, RTX_ERR otherwise
  */
 int osTaskExit(void);
@@ -130,8 +301,224 @@ void osSleep(int timeInMs);
 
 void osPeriodYield(void);
 
+/**
+ * @brief Change the relative deadline of a READY task other than the caller
+ * @param deadline New deadline in ms. For a task with a budget the new density
+ *        must still be admitted (see osCreatePeriodicTask)
+ * @param TID Task to change
+ * @return int RTX_OK on success, RTX_ERR otherwise
+ */
 int osSetDeadline(int deadline, task_t TID);
 
+/**
+ * @brief Create a task with a relative deadline and no budget. It is left out of
+ *        admission control; use osCreateDeadlineTaskBudget to have it checked
+ * @param deadline Relative deadline in ms
+ * @param task Reference TCB, ptask and stack_size must be set. Receives the TID
+ * @return int RTX_OK on success and RTX_ERR on failure
+ */
 int osCreateDeadlineTask(int deadline, TCB* task);
 
+/**
+ * @brief Create a task with a relative deadline and a worst-case CPU budget per
+ *        deadline, admitted against ADMIT_BOUND_PERCENT like osCreatePeriodicTask
+ * @param deadline Relative deadline in ms
+ * @param budget Worst-case ms of CPU within each deadline, at most deadline.
+ *        0 leaves the task out of admission control
+ * @param task Reference TCB as for osCreateDeadlineTask
+ * @return int RTX_OK on success, RTX_ERR on failure or if budget / deadline does not fit
+ */
+int osCreateDeadlineTaskBudget(int deadline, int budget, TCB* task);
+
+/**
+ * @brief Create a task on a stack the caller owns, without touching the heap.
+ *        Place the stack with K_TASK_STACK so the linker accounts for it. The
+ *        kernel never frees it: after the task exits the buffer may be reused.
+ * @param task Reference TCB, ptask must be set. stack_size is overwritten
+ * @param stack Stack buffer, 8-byte aligned
+ * @param stack_size Size of the buffer in bytes, a multiple of 8 between
+ *        MIN_STACK_SIZE and MAX_STACK_SIZE
+ * @param deadline Relative deadline in ms
+ * @param budget Worst-case ms of CPU within each deadline, as for
+ *        osCreateDeadlineTaskBudget. 0 leaves the task out of admission control
+ * @return int RTX_OK on success, RTX_ERR on failure or if budget / deadline does not fit
+ */
+int osCreateTaskStatic(TCB* task, void* stack, uint32_t stack_size, int deadline, int budget);
+
+/**
+ * @brief Create a periodic task. Releases are on a fixed grid, k_ticks at creation
+ *        plus phase plus a multiple of period, so the rate does not drift with
+ *        how long each job takes. Every job ends with osWaitNextPeriod.
+ * @param period Ms between releases
+ * @param deadline Relative deadline of each job in ms, at most period
+ * @param budget Worst-case ms of CPU per job, admitted against ADMIT_BOUND_PERCENT
+ *        (see k_sched_analysis.h). 0 leaves the task out of admission control
+ * @param phase Ms from creation to the first release, 0 to release it now
+ * @param task Reference TCB as for osCreateDeadlineTask
+ * @return int RTX_OK on success, RTX_ERR on failure or if budget / deadline does not fit
+ */
+int osCreatePeriodicTask(int period, int deadline, int budget, int phase, TCB* task);
+
+/**
+ * @brief End the current job of a periodic task and sleep until the next release.
+ *        If that release has already passed the next job starts at once; the
+ *        grid is kept, so a late task catches up with back-to-back jobs.
+ * @return int RTX_OK, or RTX_ERR if the task is not periodic
+ */
+int osWaitNextPeriod(void);
+
+/**
+ * @brief Job statistics of a periodic task or run-to-completion job
+ * @param TID The task to query
+ * @param stats Destination, times are in DWT cycles
+ * @return int RTX_OK on success, RTX_ERR if the task does not exist or is not periodic
+ */
+int osPeriodStats(task_t TID, k_period_t* stats);
+
+/**
+ * @brief Create a run-to-completion job: ptask is called once per period as a plain
+ *        function on the stack shared by all jobs (JOB_STACK_SIZE), and must return.
+ *        Jobs are scheduled by EDF like tasks and preempt each other, but a job that
+ *        was preempted by another job resumes only after that one has returned.
+ *        A job cannot sleep or wait: osSleep returns at once and blocking calls fail.
+ *        It needs no stack of its own, only the TCB.
+ * @param job Reference TCB, ptask must be set. stack_size is not used
+ * @param period Period and relative deadline in ms. The first release is now, later
+ *        ones on the same grid as osCreatePeriodicTask (straight away if it overran)
+ * @return int RTX_OK on success and RTX_ERR on failure
+ */
+int osCreateJob(TCB* job, int period);
+
+/**
+ * @brief Define a task stack in the .task_stacks linker section (not zeroed at boot).
+ *        Aligned to STACK_GUARD_SIZE so the MPU guard covers its first bytes.
+ */
+#define K_TASK_STACK(name, size) \
+	uint64_t name[(size) / 8] __attribute__((section(".task_stacks"), aligned(STACK_GUARD_SIZE)))
+
+/**
+ * @brief Entry of the task table walked by osKernelInit, see K_TASK_DEFINE
+ */
+typedef struct {
+	void (*ptask)(void* args);
+	uint64_t* stack;
+	uint16_t stack_size;
+	uint32_t deadline;
+	uint32_t budget;        // Admitted against ADMIT_BOUND_PERCENT, 0 for none
+	task_t* tid;            // Receives the TID, or TID_INVALID if the task could not be created
+} k_task_def_t;
+
+/**
+ * @brief Declare a task that exists from osKernelInit on, with no system call or heap
+ *        allocation. Defines `task_t name` holding its TID once osKernelInit returns,
+ *        a K_TASK_STACK for it, and a constant entry in the k_task_table flash section.
+ *        TIDs follow link order, so use `name` rather than a fixed number. Entries are
+ *        pinned to the struct's own alignment so the section stays a packed array even
+ *        where the compiler would over-align a large object.
+ * @param name Identifier for the TID variable
+ * @param entry Task function, declared before the macro
+ * @param size Stack size in bytes, a multiple of 8 between MIN_STACK_SIZE and MAX_STACK_SIZE
+ * @param deadline_ms Relative deadline in ms
+ */
+#define K_TASK_DEFINE(name, entry, size, deadline_ms) \
+	K_TASK_DEFINE_BUDGET(name, entry, size, deadline_ms, 0)
+
+/**
+ * @brief K_TASK_DEFINE for a task with a CPU budget. osKernelInit admits it like
+ *        osCreateDeadlineTaskBudget; if the table does not fit, `name` is TID_INVALID.
+ * @param budget_ms Worst-case ms of CPU within each deadline, at most deadline_ms
+ */
+#define K_TASK_DEFINE_BUDGET(name, entry, size, deadline_ms, budget_ms) \
+	_Static_assert((size) % 8 == 0 && (size) >= MIN_STACK_SIZE && (size) <= MAX_STACK_SIZE, #name ": bad stack size"); \
+	_Static_assert((deadline_ms) > 0, #name ": deadline must be positive"); \
+	_Static_assert((budget_ms) >= 0 && (budget_ms) <= (deadline_ms), #name ": budget must be between 0 and the deadline"); \
+	task_t name; \
+	K_TASK_STACK(name##_stack, size); \
+	static const k_task_def_t name##_def \
+		__attribute__((section("k_task_table"), used, aligned(__alignof__(k_task_def_t)))) = \
+		{ (entry), name##_stack, (size), (deadline_ms), (budget_ms), &name }
+
+/**
+ * @brief Empty system call, for measuring the syscall round trip
+ * @param value Passed in r0
+ * @return int value + 1, computed in handler mode and returned in r0
+ */
+int osSyscallPing(int value);
+
+/**
+ * @brief Get the CPU cycles a task has spent running, including the null task
+ * @param TID The task to query (TID_NULL gives the idle time)
+ * @param cycles Destination of the 64-bit cycle count
+ * @return int RTX_OK if the task exists, and RTX_ERR otherwise
+ */
+int osTaskCpuCycles(task_t TID, uint64_t* cycles);
+
+/**
+ * @brief System load since the previous call (or since osKernelStart)
+ * @return int Percentage of cycles not spent in the null task, 0-100
+ */
+int osGetCpuLoad(void);
+
+/**
+ * @brief Total density admitted so far, the sum of budget / deadline over tasks
+ *        created with a budget
+ * @return int Percentage rounded up, at most ADMIT_BOUND_PERCENT
+ */
+int osGetUtilization(void);
+
+/**
+ * @brief Find the deepest point a task's stack has reached by scanning for the
+ *        first word above stack_bot that no longer holds STACK_PAINT_PATTERN
+ * @param TID The task to query
+ * @return uint32_t Bytes of stack used at the high watermark, 0 if the TID is
+ *         invalid or STACK_PAINT is disabled
+ */
+uint32_t osTaskStackHighWater(task_t TID);
+
+/**
+ * @brief Tasks flagged by the null task's periodic stack check
+ * @return uint32_t Bit mask with bit TID set for every task that came within
+ *         STACK_WARN_MARGIN bytes of overflowing
+ */
+uint32_t osGetStackWarnings(void);
+
+/**
+ * @brief Start of a task's stack guard: the first STACK_GUARD_SIZE aligned block
+ *        inside the stack, so the heap_block_t below stack_bot stays writable by k_mem
+ * @param task The task
+ * @return uint32_t Guard base address
+ */
+static inline uint32_t stack_guard_base(TCB* task)
+{
+	return (task->stack_bot + STACK_GUARD_SIZE - 1) & ~(uint32_t)(STACK_GUARD_SIZE - 1);
+}
+
+/**
+ * @brief Lowest address of a task's stack that code may touch
+ * @param task The task
+ * @return uint32_t stack_bot, or the end of the guard region if STACK_GUARD is enabled
+ */
+static inline uint32_t stack_usable_bot(TCB* task)
+{
+#if STACK_GUARD
+	return stack_guard_base(task) + STACK_GUARD_SIZE;
+#else
+	return task->stack_bot;
+#endif
+}
+
+/**
+ * @brief Move MPU region 0 to the guard of the task about to run
+ * @param task The task being switched to
+ */
+static inline void set_stack_guard(TCB* task)
+{
+#if STACK_GUARD
+	// SIZE field encodes 2^(SIZE+1) bytes; AP = 0 is no access, even privileged
+	MPU->RBAR = stack_guard_base(task) | MPU_RBAR_VALID_Msk | 0;
+	MPU->RASR = MPU_RASR_XN_Msk | ((__builtin_ctz(STACK_GUARD_SIZE) - 1) << MPU_RASR_SIZE_Pos) | MPU_RASR_ENABLE_Msk;
+	__DSB();
+#endif
+}
+
 #endif /* INC_K_TASK_H_ */
@@ -0,0 +1,79 @@
+/*
+ * k_timer.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Software timers. Armed timers hang off a hashed timer wheel indexed by
+ *      expiry tick modulo TIMER_WHEEL_SIZE, so start and stop are O(1) and each
+ *      SysTick only looks at one slot. Expired timers are handed to a single
+ *      timer daemon task, created on the first osTimerCreate, which runs the
+ *      callbacks in thread mode under EDF like any other task.
+ */
+#include <stdio.h>
+#include "common.h"
+
+#ifndef INC_K_TIMER_H_
+#define INC_K_TIMER_H_
+
+typedef void (*k_timer_cb_t)(void* arg);
+
+typedef struct k_timer {
+    struct k_timer* next;       // Circular doubly linked list of the slot (or expired list)
+    struct k_timer* prev;
+    struct k_timer** list;      // Head of the list the timer is on, NULL when stopped
+    k_timer_cb_t callback;      // Run by the timer daemon
+    void* arg;
+    uint32_t period;            // Reload period in ms, 0 for a one-shot timer
+    uint32_t expires;           // Absolute tick of the next expiry
+} k_timer_t;
+
+/**
+ * @brief Advance the timer wheel by one tick. Called from SysTick_Handler.
+ */
+void k_timer_tick(void);
+
+/**
+ * @brief Advance the timer wheel by several ticks at once, after a tickless sleep
+ * @param ticks Ticks to skip, fewer than k_timer_next() so no timer expires
+ */
+void k_timer_skip(uint32_t ticks);
+
+/**
+ * @brief Initialize a stopped timer. Creates the timer daemon on first use.
+ * @param timer The timer
+ * @param callback Function run by the daemon on every expiry, must not block for long
+ * @param arg Passed to callback
+ * @return int RTX_OK on success, RTX_ERR if callback is NULL or the daemon could not be created
+ */
+int osTimerCreate(k_timer_t* timer, k_timer_cb_t callback, void* arg);
+
+/**
+ * @brief Arm a timer, restarting it if it is already running
+ * @param timer The timer
+ * @param delay Ms until the first expiry, at least 1
+ * @param period Ms between later expiries, 0 for one-shot
+ * @return int RTX_OK on success, RTX_ERR if delay is 0
+ */
+int osTimerStart(k_timer_t* timer, uint32_t delay, uint32_t period);
+
+/**
+ * @brief Disarm a timer. A callback the daemon has already picked up still runs.
+ * @param timer The timer
+ * @return int RTX_OK on success, RTX_ERR if the timer was not running
+ */
+int osTimerStop(k_timer_t* timer);
+
+/**
+ * @brief Check whether a timer is armed or waiting for the daemon
+ * @param timer The timer
+ * @return int 1 if running, 0 otherwise
+ */
+int osTimerIsActive(k_timer_t* timer);
+
+/**
+ * @brief Ticks until the next timer expiry, for tickless idle
+ * @return uint32_t 0 if callbacks are waiting for the daemon, UINT32_MAX if no timer is armed
+ */
+uint32_t k_timer_next(void);
+
+#endif /* INC_K_TIMER_H_ */
@@ -0,0 +1,98 @@
+/*
+ * k_trace.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Kernel event tracer. With TRACE_ENABLE set, the scheduler, SVC handler,
+ *      tick and ready queue write 8-byte records (DWT timestamp, event, tid,
+ *      argument) into the k_trace RAM ring. With TRACE_ENABLE clear every hook
+ *      compiles to nothing.
+ *
+ *      To inspect a schedule, stop the target and dump the ring with GDB:
+ *          dump binary value trace.bin k_trace
+ *      then convert it with Tools/trace_to_chrome.py and open the JSON in
+ *      chrome://tracing or Perfetto.
+ */
+#include <stdint.h>
+#include "main.h"
+#include "common.h"
+
+#ifndef INC_K_TRACE_H_
+#define INC_K_TRACE_H_
+
+#define K_TRACE_MAGIC 0x45435254    // "TRCE"
+
+// Events, tid is the task the event is about
+#define K_TRACE_SWITCH 1            // tid switched out, arg = tid switched in
+#define K_TRACE_SVC 2               // arg = SVC number
+#define K_TRACE_TICK 3              // tid = running task
+#define K_TRACE_READY 4             // tid queued, arg = time_left, saturated at K_TRACE_ARG_MAX
+#define K_TRACE_POP 5               // tid taken from the ready queue, arg = tasks still queued
+#define K_TRACE_ISR_ENTER 6         // arg = exception number
+#define K_TRACE_ISR_EXIT 7
+#define K_TRACE_USER 8              // Free for application markers
+
+#define K_TRACE_ARG_MAX 0xFFFF      // arg is 16 bits, wider values are clamped to this
+
+typedef struct k_trace_rec {
+    uint32_t stamp;                 // DWT->CYCCNT
+    uint8_t type;                   // K_TRACE_*
+    uint8_t tid;
+    uint16_t arg;
+} k_trace_rec_t;
+
+typedef struct k_trace {
+    uint32_t magic;                 // K_TRACE_MAGIC, lets the converter check the dump
+    uint32_t count;                 // Records written, the newest is rec[(count - 1) % size]
+    uint32_t size;                  // TRACE_RECORDS
+    uint32_t clock;                 // Core clock in Hz for the timestamps
+    volatile uint32_t enabled;
+    k_trace_rec_t rec[TRACE_RECORDS];
+} k_trace_t;
+
+#if TRACE_ENABLE
+
+extern k_trace_t k_trace;
+
+static inline void k_trace_event(uint8_t type, uint8_t tid, uint16_t arg)
+{
+	if (!k_trace.enabled) {
+		return;
+	}
+
+	// Hooks run at every kernel priority level, so claim the slot with IRQs masked
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	k_trace_rec_t* r = &k_trace.rec[k_trace.count++ & (TRACE_RECORDS - 1)];
+	r->stamp = DWT->CYCCNT;
+	r->type = type;
+	r->tid = tid;
+	r->arg = arg;
+	__set_PRIMASK(primask);
+}
+
+#define K_TRACE(type, tid, arg) k_trace_event((type), (tid), (arg))
+#define K_TRACE_ISR_BEGIN() k_trace_event(K_TRACE_ISR_ENTER, 0, __get_IPSR())
+#define K_TRACE_ISR_END() k_trace_event(K_TRACE_ISR_EXIT, 0, __get_IPSR())
+
+/**
+ * @brief Clear the ring and start recording. Called by osKernelInit.
+ */
+void osTraceStart(void);
+
+/**
+ * @brief Stop recording so the ring can be dumped without being overwritten
+ */
+void osTraceStop(void);
+
+#else
+
+#define K_TRACE(type, tid, arg) ((void)0)
+#define K_TRACE_ISR_BEGIN() ((void)0)
+#define K_TRACE_ISR_END() ((void)0)
+#define osTraceStart() ((void)0)
+#define osTraceStop() ((void)0)
+
+#endif /* TRACE_ENABLE */
+
+#endif /* INC_K_TRACE_H_ */
@@ -0,0 +1,63 @@
+/*
+ * k_work.h
+ *
+ *  Created on: Oct 19, 2026
+ *
+ *      Deferred interrupt work. An ISR submits a k_work_t with a lock-free
+ *      push (LDREX/STREX) and returns; the system work queue task drains the
+ *      queue under EDF with the deadline given to osWorkQueueCreate. A work
+ *      item that is already pending is not queued again, so bursts of the same
+ *      interrupt coalesce into one run.
+ */
+#include <stdio.h>
+#include "common.h"
+
+#ifndef INC_K_WORK_H_
+#define INC_K_WORK_H_
+
+typedef void (*k_work_fn_t)(void* arg);
+
+typedef struct k_work {
+    struct k_work* next;        // Link in the submit stack
+    k_work_fn_t fn;             // Run by the work queue task
+    void* arg;
+    volatile uint32_t pending;  // 1 from submit until fn starts (LDREX/STREX target)
+    uint32_t submitted;         // DWT cycle count of the submit that queued the item
+    // Statistics, updated by the work queue task
+    uint32_t runs;              // Times fn was run
+    volatile uint32_t coalesced;// Submits dropped because the item was already pending
+    uint32_t latency_min;       // Cycles from submit to the start of fn
+    uint32_t latency_max;
+    uint64_t latency_sum;       // Divide by runs for the average
+} k_work_t;
+
+/**
+ * @brief Create the work queue task. Call once, before or after osKernelStart.
+ * @param deadline Deadline in ms of the work queue task
+ * @return int RTX_OK on success, RTX_ERR if the task could not be created or already exists
+ */
+int osWorkQueueCreate(int deadline);
+
+/**
+ * @brief Initialize a work item and clear its statistics
+ * @param work The work item
+ * @param fn Function to run in the work queue task
+ * @param arg Passed to fn
+ */
+void osWorkInit(k_work_t* work, k_work_fn_t fn, void* arg);
+
+/**
+ * @brief Queue a work item from a task
+ * @param work The work item
+ * @return int RTX_OK if queued, RTX_ERR if it was already pending (coalesced)
+ */
+int osWorkSubmit(k_work_t* work);
+
+/**
+ * @brief Queue a work item from an interrupt handler running at KERNEL_IRQ_PRIORITY
+ * @param work The work item
+ * @return int RTX_OK if queued, RTX_ERR if it was already pending (coalesced)
+ */
+int osWorkSubmitFromISR(k_work_t* work);
+
+#endif /* INC_K_WORK_H_ */
@@ -57,6 +57,11 @@ void SystemClock_Config(void);
 void MX_GPIO_Init(void);
 void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN EFP */
+int log_write(const char* buf, int len);
+int log_write_all(const char* buf, int len); // RTX_ERR (and counted as dropped) unless all of buf fits
+uint32_t log_dropped_count(void);
+uint32_t log_pending(void);
+void log_retry(void); // Restart a log DMA that could not start, IRQs masked (SysTick)
 
 /* USER CODE END EFP */
 
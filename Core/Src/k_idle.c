@@ -0,0 +1,295 @@
+#include "main.h"
+#include "common.h"
+#include "k_task.h"
+#include "k_timer.h"
+#include "k_idle.h"
+
+#include <stddef.h>
+
+// LSI is nominally 32 kHz: PREDIV_A + 1 = 32 gives a 1 kHz subsecond counter. The
+// datasheet allows 17-47 kHz, so lsi_calibrate measures it against the core clock and
+// the wakeup interval and the measured sleep use that instead of the nominal value.
+#define RTC_LSI_HZ 32000
+#define RTC_PREDIV_A 31
+#define RTC_PREDIV_S 999
+#define RTC_WAKEUP_DIV 16                // WUCKSEL = RTC/16
+#define RTC_HOUR_STEPS 3600000           // Subsecond steps before the minute/second fields wrap
+#define LSI_CAL_STEPS 100                // Subsecond steps (~100 ms) to measure the LSI over
+
+// Polls for the PLL to lock and SYSCLK to switch, far above the ~100 us they take on HSI
+#define CLOCK_WAIT_SPINS 100000
+
+volatile uint32_t idle_wake_stamp = 0;
+uint32_t idle_lsi_hz = RTC_LSI_HZ;
+
+static int idle_mode = IDLE_MODE;
+static void (*idle_hooks[IDLE_HOOKS_MAX])(void);
+static uint8_t idle_hook_count = 0;
+static uint8_t rtc_ready = 0;
+static uint8_t lsi_stale = 1;
+static uint32_t slept_rem = 0; // Fraction of a ms left over by the last STOP, in 1/idle_lsi_hz ms
+
+static void rtc_init(void)
+{
+	RCC->CSR |= RCC_CSR_LSION;
+	while (!(RCC->CSR & RCC_CSR_LSIRDY));
+
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR |= PWR_CR_DBP;
+	RCC->BDCR = (RCC->BDCR & ~RCC_BDCR_RTCSEL) | RCC_BDCR_RTCSEL_1 | RCC_BDCR_RTCEN; // LSI
+
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->ISR |= RTC_ISR_INIT;
+	while (!(RTC->ISR & RTC_ISR_INITF));
+	RTC->PRER = (RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos) | RTC_PREDIV_S;
+	RTC->ISR &= ~(RTC_ISR_INIT | RTC_ISR_RSF);
+
+	RTC->CR &= ~RTC_CR_WUTE;
+	while (!(RTC->ISR & RTC_ISR_WUTWF));
+	RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUTIE; // RTC/16
+	RTC->WPR = 0xFF;
+
+	// The wakeup timer reaches the NVIC through EXTI line 22
+	EXTI->IMR |= EXTI_IMR_MR22;
+	EXTI->RTSR |= EXTI_RTSR_TR22;
+	HAL_NVIC_SetPriority(RTC_WKUP_IRQn, KERNEL_IRQ_PRIORITY, 0);
+	HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+	while (!(RTC->ISR & RTC_ISR_RSF));
+	rtc_ready = 1;
+}
+
+static void rtc_wakeup_in(uint32_t ms)
+{
+	// A fast LSI overflows the 16-bit counter near IDLE_STOP_MAX_MS; waking early is harmless
+	uint32_t count = (uint64_t)ms * idle_lsi_hz / (RTC_WAKEUP_DIV * 1000);
+	if (count > 0x10000) count = 0x10000;
+	if (count == 0) count = 1;
+
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->CR &= ~RTC_CR_WUTE;
+	while (!(RTC->ISR & RTC_ISR_WUTWF));
+	RTC->WUTR = count - 1;
+	RTC->ISR &= ~RTC_ISR_WUTF;
+	RTC->CR |= RTC_CR_WUTE;
+	RTC->WPR = 0xFF;
+}
+
+static void rtc_wakeup_stop(void)
+{
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->CR &= ~RTC_CR_WUTE;
+	RTC->ISR &= ~RTC_ISR_WUTF;
+	RTC->WPR = 0xFF;
+	EXTI->PR = EXTI_PR_PR22;
+}
+
+// Subsecond steps (ms at the nominal LSI) within the current hour, from the calendar
+// and subsecond counter
+static uint32_t rtc_steps(void)
+{
+	uint32_t ssr = RTC->SSR; // Locks TR/DR until DR is read
+	uint32_t tr = RTC->TR;
+	(void)RTC->DR;
+
+	uint32_t sec = ((tr & RTC_TR_ST) >> RTC_TR_ST_Pos) * 10 + ((tr & RTC_TR_SU) >> RTC_TR_SU_Pos);
+	uint32_t min = ((tr & RTC_TR_MNT) >> RTC_TR_MNT_Pos) * 10 + ((tr & RTC_TR_MNU) >> RTC_TR_MNU_Pos);
+	return (min * 60 + sec) * 1000 + (RTC_PREDIV_S - ssr);
+}
+
+// Wait for the subsecond counter to step and stamp the core clock. Masked so the
+// stamp belongs to that step; the wait lasts at most one step, under 2 ms
+static uint32_t rtc_edge(uint32_t* cycles)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint32_t from = rtc_steps();
+	uint32_t now;
+	while ((now = rtc_steps()) == from);
+	*cycles = DWT->CYCCNT;
+	__set_PRIMASK(primask);
+	return now;
+}
+
+// Measure the LSI against SystemCoreClock over LSI_CAL_STEPS subsecond steps. Only
+// the two edges are masked, so interrupts and tasks may run in between.
+static void lsi_calibrate(void)
+{
+	uint32_t c0, c1;
+	uint32_t s0 = rtc_edge(&c0);
+	uint32_t steps;
+	do {
+		steps = (rtc_edge(&c1) + RTC_HOUR_STEPS - s0) % RTC_HOUR_STEPS;
+	} while (steps < LSI_CAL_STEPS);
+
+	idle_lsi_hz = (uint64_t)SystemCoreClock * steps * (RTC_PREDIV_A + 1) / (c1 - c0);
+	slept_rem = 0;
+	lsi_stale = 0;
+}
+
+// Ticks until something in the kernel is due, capped at IDLE_STOP_MAX_MS
+static uint32_t idle_ticks(void)
+{
+	uint32_t ticks = IDLE_STOP_MAX_MS;
+	for (int i = 1; i < MAX_TASKS; i++)
+	{
+		TCB* t = &task_list[i];
+		if ((t->state == SLEEPING || (t->state == BLOCKED && t->sleep_time > 0)) && t->sleep_time < ticks) {
+			ticks = t->sleep_time;
+		}
+	}
+
+	uint32_t timer = k_timer_next();
+	return (timer < ticks) ? timer : ticks;
+}
+
+static void idle_account(uint32_t cycles)
+{
+	task_list[TID_NULL].cpu_cycles += cycles;
+	cpu_total += cycles;
+}
+
+static void idle_wfi(void)
+{
+	// SysTick keeps counting in sleep mode, use it to measure the nap
+	uint32_t load = SysTick->LOAD + 1;
+	(void)SysTick->CTRL; // Clears COUNTFLAG
+	uint32_t before = SysTick->VAL;
+
+	__DSB();
+	__WFI();
+	idle_wake_stamp = DWT->CYCCNT;
+
+	uint32_t after = SysTick->VAL;
+	uint32_t slept = (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) ?
+			before + load - after : before - after;
+	idle_account(slept);
+}
+
+// STOP leaves the core on HSI with the PLL off. Its configuration, the flash wait
+// states and the bus prescalers survive, so turning it back on is enough. Unlike
+// SystemClock_Config this does not go through HAL_InitTick, which would move SysTick
+// to TICK_INT_PRIORITY, and its waits do not depend on the suspended HAL tick.
+static void clock_restore(void)
+{
+	uint32_t spins = CLOCK_WAIT_SPINS;
+	RCC->CR |= RCC_CR_PLLON;
+	while (!(RCC->CR & RCC_CR_PLLRDY) && --spins);
+	if (spins == 0) Error_Handler();
+
+	spins = CLOCK_WAIT_SPINS;
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+	while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL && --spins);
+	if (spins == 0) Error_Handler();
+}
+
+static void idle_stop(uint32_t ms)
+{
+	HAL_SuspendTick();
+	uint32_t start = rtc_steps();
+	rtc_wakeup_in(ms);
+
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+	idle_wake_stamp = DWT->CYCCNT;
+
+	clock_restore();
+	rtc_wakeup_stop();
+
+	// Shadow registers are stale after STOP until the next RTC sync
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	RTC->ISR &= ~RTC_ISR_RSF;
+	RTC->WPR = 0xFF;
+	while (!(RTC->ISR & RTC_ISR_RSF));
+
+	// Steps are (PREDIV_A + 1) LSI periods; keep the remainder so repeated STOPs don't drift
+	uint32_t steps = (rtc_steps() + RTC_HOUR_STEPS - start) % RTC_HOUR_STEPS;
+	uint64_t scaled = (uint64_t)steps * (RTC_PREDIV_A + 1) * 1000 + slept_rem;
+	uint32_t slept = scaled / idle_lsi_hz;
+	slept_rem = scaled % idle_lsi_hz;
+	idle_account(slept * (SystemCoreClock / 1000));
+	k_idle_compensate(slept);
+	HAL_ResumeTick();
+}
+
+void k_idle_compensate(uint32_t ms)
+{
+	// Nothing is due before the wakeup idle_stop programmed: jump over the quiet
+	// ticks in one step, so interrupts stay masked for a bounded time, and only
+	// run the tick handlers for the last one and any the RTC measured beyond it
+	uint32_t quiet = idle_ticks();
+	uint32_t skip = (ms < quiet) ? ms : (quiet ? quiet - 1 : 0);
+	uwTick += skip * uwTickFreq;
+	tick_skip(skip);
+	k_timer_skip(skip);
+
+	for (uint32_t i = skip; i < ms; i++)
+	{
+		HAL_IncTick();
+		tick_time_left();
+		k_timer_tick();
+	}
+}
+
+void k_idle(void)
+{
+	for (int i = 0; i < idle_hook_count; i++) {
+		idle_hooks[i]();
+	}
+
+	if (idle_mode == IDLE_RUN) {
+		return;
+	}
+
+	// Calibrating the LSI takes ~100 ms of idle time and needs SysTick, so it runs
+	// here with interrupts enabled, before the first STOP
+	if (idle_mode == IDLE_STOP && lsi_stale) {
+		if (!rtc_ready) rtc_init();
+		lsi_calibrate();
+		return;
+	}
+
+	// PRIMASK rather than BASEPRI: WFI only wakes on interrupts BASEPRI lets through,
+	// and an interrupt between the check and WFI must still end the sleep
+	__disable_irq();
+	if (prio_q_size == 0)
+	{
+		uint32_t ticks = (idle_mode == IDLE_STOP) ? idle_ticks() : 0;
+
+		// DMA stops in STOP mode, so wait for the log ring to drain first
+		if (ticks >= IDLE_STOP_MIN_MS && log_pending() == 0) {
+			idle_stop(ticks);
+		} else {
+			idle_wfi();
+		}
+	}
+	__enable_irq();
+}
+
+int osIdleSetMode(int mode)
+{
+	if (mode != IDLE_RUN && mode != IDLE_WFI && mode != IDLE_STOP) {
+		return RTX_ERR;
+	}
+
+	// Measure the LSI again before the next STOP: it drifts with temperature and supply voltage
+	if (mode == IDLE_STOP) {
+		lsi_stale = 1;
+	}
+
+	idle_mode = mode;
+	return RTX_OK;
+}
+
+int osIdleHookAdd(void (*hook)(void))
+{
+	if (hook == NULL || idle_hook_count >= IDLE_HOOKS_MAX) {
+		return RTX_ERR;
+	}
+
+	idle_hooks[idle_hook_count++] = hook;
+	return RTX_OK;
+}
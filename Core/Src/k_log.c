@@ -0,0 +1,22 @@
+#include "main.h"
+#include "common.h"
+#include "k_log.h"
+
+#if !LOG_ASYNC
+#error "KLOG records go through the DMA log ring, set LOG_ASYNC"
+#endif
+
+void klog_write(const char* fmt, const uint32_t* args, uint32_t nargs)
+{
+	uint32_t rec[2 + KLOG_MAX_ARGS];
+
+	// .klog_fmt is linked at address 0, so the string address is its offset
+	rec[0] = ((uint32_t)fmt << 16) | (nargs << 8) | KLOG_SYNC;
+	rec[1] = DWT->CYCCNT;
+	for (uint32_t i = 0; i < nargs; i++) {
+		rec[2 + i] = args[i];
+	}
+
+	// A partial record would break the decoder's framing: all of it or nothing
+	log_write_all((const char*)rec, (2 + nargs) * sizeof(uint32_t));
+}
@@ -16,8 +16,8 @@ heap_block_t* k_mem_pop_free(heap_block_t* current, size_t aligned_size)
 	size_t split_size = aligned_size + sizeof(heap_block_t);
 
     // Update current block metadata
-    // Get current task ID or kernel for ownership
-    current->tid = (current_task->tid != TID_NULL) ? current_task->tid : TID_NULL;
+    // Get current task ID or kernel for ownership (no current task before osKernelStart)
+    current->tid = (current_task != NULL) ? current_task->tid : TID_NULL;
     current->status = OCCUPIED;
 
 	if (current->aligned_size >= split_size + MIN_BLOCK_SIZE) {
@@ -25,11 +25,11 @@ heap_block_t* k_mem_pop_free(heap_block_t* current, size_t aligned_size)
 		// We do this so that we only split a node if we could have used
 		// extra space for more allocations.
 
-		heap_block_t* new_free = (heap_block_t*) ((uint32_t) current->start + aligned_size);
+		heap_block_t* new_free = (heap_block_t*) ((uint32_t)(uintptr_t)current->start + aligned_size);
 
 		// do stuff with metadata
 		new_free->tid = TID_INVALID;
-		new_free->start = (uint32_t*) ((uint32_t) current->start + split_size);
+		new_free->start = (uint32_t*) ((uint32_t)(uintptr_t)current->start + split_size);
 		new_free->status = FREE;
 
 		// Update size to aligned
@@ -238,6 +238,20 @@ int k_mem_dealloc(void* ptr)
     return RTX_ERR;
 }
 
+heap_block_t* k_mem_block(void* ptr)
+{
+	if ((uint32_t)(uintptr_t)ptr < HEAP_START + sizeof(heap_block_t) || (uint32_t)(uintptr_t)ptr >= HEAP_END) {
+		return NULL;
+	}
+
+	// Data always starts right after its metadata
+	heap_block_t* block = (heap_block_t*) ((uint32_t)(uintptr_t)ptr - sizeof(heap_block_t));
+	if (block->start != ptr || block->status != OCCUPIED) {
+		return NULL;
+	}
+	return block;
+}
+
 int k_mem_count_extfrag(size_t size) {
     // returns the number of free memory regions strictly less than size, including the size of the data structure
     int count = 0;
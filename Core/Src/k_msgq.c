@@ -0,0 +1,156 @@
+#include "main.h"
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+#include "k_sync.h"
+#include "k_msgq.h"
+
+#include <stddef.h>
+
+// Append to the ring, the caller has checked there is room
+static void msgq_put(k_msgq_t* q, void* msg)
+{
+	uint32_t tail = q->head + q->count;
+	if (tail >= q->capacity) tail -= q->capacity;
+	q->buf[tail] = msg;
+	q->count++;
+}
+
+static void* msgq_get(k_msgq_t* q)
+{
+	void* msg = q->buf[q->head];
+	if (++q->head == q->capacity) q->head = 0;
+	q->count--;
+	return msg;
+}
+
+// Queue a message the caller has given up, or hand it to a waiting receiver
+static int msgq_deliver(k_msgq_t* q, void* msg, heap_block_t* block)
+{
+	TCB* receiver = wait_wake_one(&q->receivers, RTX_OK);
+	if (receiver)
+	{
+		receiver->wait_msg = msg;
+		if (block) block->tid = receiver->tid;
+		preempt_check(receiver);
+		return RTX_OK;
+	}
+
+	if (q->count == q->capacity)
+	{
+		return RTX_ERR;
+	}
+
+	// Kernel owns the buffer while it sits in the ring
+	if (block) block->tid = TID_NULL;
+	msgq_put(q, msg);
+	return RTX_OK;
+}
+
+void k_msgq_send(k_msgq_t* q, void* msg, uint32_t timeout)
+{
+	heap_block_t* block = k_mem_block(msg);
+	if (block == NULL || block->tid != current_task->tid)
+	{
+		current_task->wait_result = RTX_ERR;
+		return;
+	}
+
+	current_task->wait_result = msgq_deliver(q, msg, block);
+	if (current_task->wait_result == RTX_OK || timeout == 0)
+	{
+		return;
+	}
+
+	// Full: keep ownership until a receiver makes room
+	current_task->wait_msg = msg;
+	wait_block(&q->senders, timeout);
+}
+
+void k_msgq_receive(k_msgq_t* q, uint32_t timeout)
+{
+	if (q->count == 0)
+	{
+		current_task->wait_result = RTX_ERR;
+		if (timeout != 0) {
+			wait_block(&q->receivers, timeout);
+		}
+		return;
+	}
+
+	void* msg = msgq_get(q);
+	heap_block_t* block = k_mem_block(msg);
+	if (block) block->tid = current_task->tid;
+	current_task->wait_msg = msg;
+	current_task->wait_result = RTX_OK;
+
+	// A slot opened up: move the earliest deadline blocked sender's message in
+	TCB* sender = wait_wake_one(&q->senders, RTX_OK);
+	if (sender)
+	{
+		block = k_mem_block(sender->wait_msg);
+		if (block) block->tid = TID_NULL;
+		msgq_put(q, sender->wait_msg);
+		preempt_check(sender);
+	}
+}
+
+int osMsgQueueCreate(k_msgq_t* q, uint32_t capacity)
+{
+	if (capacity == 0) {
+		return RTX_ERR;
+	}
+
+	q->buf = k_mem_alloc(capacity * sizeof(void*));
+	if (q->buf == NULL) {
+		return RTX_ERR;
+	}
+
+	q->capacity = capacity;
+	q->head = 0;
+	q->count = 0;
+	q->senders.head = NULL;
+	q->senders.mutex = NULL;
+	q->receivers.head = NULL;
+	q->receivers.mutex = NULL;
+	return RTX_OK;
+}
+
+int osMsgQueueDelete(k_msgq_t* q)
+{
+	if (q->count || q->senders.head || q->receivers.head) {
+		return RTX_ERR;
+	}
+
+	int ret = k_mem_dealloc(q->buf);
+	if (ret == RTX_OK) {
+		q->buf = NULL;
+		q->capacity = 0;
+	}
+	return ret;
+}
+
+int osMsgQueueSend(k_msgq_t* q, void* msg, uint32_t timeout)
+{
+	__svc_arg3(SVC_MSGQ_SEND, q, msg, timeout);
+	return current_task->wait_result;
+}
+
+int osMsgQueueReceive(k_msgq_t* q, void** msg, uint32_t timeout)
+{
+	__svc_arg2(SVC_MSGQ_RECEIVE, q, timeout);
+	if (current_task->wait_result != RTX_OK) {
+		return RTX_ERR;
+	}
+
+	*msg = current_task->wait_msg;
+	return RTX_OK;
+}
+
+int osMsgQueueSendFromISR(k_msgq_t* q, void* msg)
+{
+	uint32_t basepri = k_crit_enter();
+	int result = msgq_deliver(q, msg, k_mem_block(msg));
+	k_crit_exit(basepri);
+	return result;
+}
@@ -0,0 +1,134 @@
+#include "common.h"
+#include "k_sched_analysis.h"
+
+#include <stddef.h>
+
+// Longest busy period examined, in ticks; a longer one means the set cannot be checked
+#define DEMAND_HORIZON 0x7FFFFFFFU
+
+static uint32_t density_total = 0; // Sum of k_density over the admitted tasks
+
+/********************
+ * 					*
+ * ADMISSION		*
+ * 					*
+ ********************/
+
+uint32_t k_density(uint32_t budget, uint32_t deadline)
+{
+	if (budget == 0) return 0;
+	if (deadline == 0) return UINT32_MAX;
+
+	uint64_t density = (((uint64_t)budget << 16) + deadline - 1) / deadline;
+	return (density > UINT32_MAX) ? UINT32_MAX : (uint32_t)density;
+}
+
+void k_admit_init(void)
+{
+	density_total = 0;
+}
+
+int k_admit(uint32_t remove, uint32_t add)
+{
+	uint64_t total = (uint64_t)density_total - remove + add;
+	if (add > remove && total > (uint64_t)ADMIT_BOUND_PERCENT * DENSITY_ONE / 100) {
+		return RTX_ERR;
+	}
+	density_total = (uint32_t)total;
+	return RTX_OK;
+}
+
+uint32_t k_density_total(void)
+{
+	return density_total;
+}
+
+/********************
+ * 					*
+ * ANALYSIS			*
+ * 					*
+ ********************/
+
+int k_sched_utilization_test(const k_task_param_t* tasks, int n)
+{
+	// Sum of C/T <= 1 in exact arithmetic: compare C/T fractions against the
+	// remaining capacity as (num / den), keeping den the product of the periods seen
+	uint64_t num = 0, den = 1;
+	for (int i = 0; i < n; i++) {
+		if (tasks[i].period == 0) return RTX_ERR;
+		num = num * tasks[i].period + tasks[i].budget * den;
+		den *= tasks[i].period;
+
+		// Keep the fraction small; beyond 2^32 fall back to a rounded-up Q32 sum
+		if (den > UINT32_MAX) {
+			uint64_t q32 = 0;
+			for (int j = 0; j < n; j++) {
+				if (tasks[j].period == 0) return RTX_ERR;
+				q32 += (((uint64_t)tasks[j].budget << 32) + tasks[j].period - 1) / tasks[j].period;
+			}
+			return (q32 <= (1ULL << 32)) ? RTX_OK : RTX_ERR;
+		}
+	}
+	return (num <= den) ? RTX_OK : RTX_ERR;
+}
+
+// Demand of all jobs released at 0 and later with deadlines at or before t
+static uint64_t demand(const k_task_param_t* tasks, int n, uint64_t t)
+{
+	uint64_t dbf = 0;
+	for (int i = 0; i < n; i++) {
+		if (t >= tasks[i].deadline) {
+			dbf += ((t - tasks[i].deadline) / tasks[i].period + 1) * tasks[i].budget;
+		}
+	}
+	return dbf;
+}
+
+// Length of the synchronous busy period: w = sum of ceil(w / T) * C at the fixed point
+static uint64_t busy_period(const k_task_param_t* tasks, int n)
+{
+	uint64_t w = 0;
+	for (int i = 0; i < n; i++) w += tasks[i].budget;
+
+	while (w > 0 && w <= DEMAND_HORIZON) {
+		uint64_t next = 0;
+		for (int i = 0; i < n; i++) {
+			next += (w + tasks[i].period - 1) / tasks[i].period * tasks[i].budget;
+		}
+		if (next == w) return w;
+		w = next;
+	}
+	return w;
+}
+
+int k_sched_demand_test(const k_task_param_t* tasks, int n, uint32_t* miss_at)
+{
+	if (miss_at) *miss_at = 0;
+	for (int i = 0; i < n; i++) {
+		if (tasks[i].deadline == 0 || tasks[i].deadline > tasks[i].period) return RTX_ERR;
+	}
+	if (k_sched_utilization_test(tasks, n) != RTX_OK) return RTX_ERR;
+
+	// With utilization at most 1 the busy period is finite, and a deadline miss, if
+	// any, happens at an absolute deadline inside it
+	uint64_t limit = busy_period(tasks, n);
+	if (limit > DEMAND_HORIZON) return RTX_ERR;
+
+	// Visit the absolute deadlines in increasing order
+	uint64_t t = 0;
+	while (1) {
+		uint64_t next = UINT64_MAX;
+		for (int i = 0; i < n; i++) {
+			uint64_t d = tasks[i].deadline;
+			if (t >= d) d += ((t - d) / tasks[i].period + 1) * tasks[i].period;
+			if (d < next) next = d;
+		}
+		if (next > limit) return RTX_OK;
+
+		t = next;
+		if (demand(tasks, n, t) > t) {
+			if (miss_at) *miss_at = (uint32_t)t;
+			return RTX_ERR;
+		}
+	}
+}
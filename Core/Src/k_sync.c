@@ -0,0 +1,455 @@
+#include "main.h"
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+
+#include <stddef.h>
+
+/********************
+ * 					*
+ * WAIT QUEUES		*
+ * 					*
+ ********************/
+
+void wait_insert(wait_queue_t* q, TCB* task)
+{
+	// Walk past every waiter that should run before task (same order as the ready heap)
+	TCB** link = &q->head;
+	while (*link && !heap_swap_check(*link, task))
+	{
+		link = &(*link)->next_waiter;
+	}
+	task->next_waiter = *link;
+	*link = task;
+	task->wait_q = q;
+}
+
+void wait_remove(TCB* task)
+{
+	if (task->wait_q == NULL) {
+		return;
+	}
+
+	TCB** link = &task->wait_q->head;
+	while (*link && *link != task)
+	{
+		link = &(*link)->next_waiter;
+	}
+	if (*link) {
+		*link = task->next_waiter;
+	}
+	task->next_waiter = NULL;
+	task->wait_q = NULL;
+}
+
+void wait_block(wait_queue_t* q, uint32_t timeout)
+{
+	// A job keeps its frame on the shared stack until it returns, the wait fails at once
+	if (current_task->job != JOB_NONE) {
+		current_task->wait_result = RTX_ERR;
+		return;
+	}
+
+	current_task->state = BLOCKED;
+	current_task->wait_result = RTX_ERR;
+	current_task->sleep_time = (timeout == OS_WAIT_FOREVER) ? 0 : timeout;
+	wait_insert(q, current_task);
+	SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+	__ISB();
+}
+
+void wait_wake(TCB* task, int result)
+{
+	wait_remove(task);
+	task->wait_result = result;
+	task->state = READY;
+	queue_task(task);
+}
+
+TCB* wait_wake_one(wait_queue_t* q, int result)
+{
+	TCB* task = q->head;
+	if (task == NULL) {
+		return NULL;
+	}
+
+	wait_wake(task, result);
+	return task;
+}
+
+void inherit_deadline(TCB* owner, uint32_t time_left)
+{
+	while (owner && time_left < owner->time_left)
+	{
+		owner->inherit_delta += owner->time_left - time_left;
+		owner->time_left = time_left;
+
+		if (owner->state == READY) {
+			update_heap(owner->tid);
+			return;
+		}
+		if (owner->state != BLOCKED || owner->wait_q->mutex == NULL) {
+			return;
+		}
+
+		// Owner is itself waiting on a mutex: move it up that queue and boost the next holder
+		wait_queue_t* q = owner->wait_q;
+		wait_remove(owner);
+		wait_insert(q, owner);
+		owner = (TCB*)(uintptr_t)q->mutex->owner;
+	}
+}
+
+/********************
+ * 					*
+ * SEMAPHORE		*
+ * 					*
+ ********************/
+
+void k_sem_take(k_sem_t* sem, uint32_t timeout)
+{
+	// Given between the failed fast path and the SVC
+	if (sem->count > 0)
+	{
+		sem->count--;
+		current_task->wait_result = RTX_OK;
+		return;
+	}
+
+	wait_block(&sem->waiters, timeout);
+}
+
+void k_sem_give(k_sem_t* sem)
+{
+	TCB* waiter = wait_wake_one(&sem->waiters, RTX_OK);
+	if (waiter == NULL)
+	{
+		sem->count++;
+		return;
+	}
+
+	// The unit goes straight to the waiter, count is untouched
+	preempt_check(waiter);
+}
+
+void osSemaphoreInit(k_sem_t* sem, uint32_t count)
+{
+	sem->count = count;
+	sem->waiters.head = NULL;
+	sem->waiters.mutex = NULL;
+}
+
+int osSemaphoreTake(k_sem_t* sem, uint32_t timeout)
+{
+	while (1) {
+		uint32_t count = __LDREXW(&sem->count);
+		if (count == 0) {
+			__CLREX();
+			break;
+		}
+		if (__STREXW(count - 1, &sem->count) == 0) {
+			__DMB();
+			return RTX_OK;
+		}
+	}
+
+	if (timeout == 0) {
+		return RTX_ERR;
+	}
+
+	__svc_arg2(SVC_SEM_TAKE, sem, timeout);
+	return current_task->wait_result;
+}
+
+int osSemaphoreGive(k_sem_t* sem)
+{
+	// Same monitor argument as osMutexUnlock: a task blocking in between clears it
+	__DMB();
+	while (1) {
+		uint32_t count = __LDREXW(&sem->count);
+		if (sem->waiters.head) {
+			__CLREX();
+			break;
+		}
+		if (__STREXW(count + 1, &sem->count) == 0) {
+			return RTX_OK;
+		}
+	}
+
+	__svc_arg(SVC_SEM_GIVE, sem);
+	return RTX_OK;
+}
+
+void osSemaphoreGiveFromISR(k_sem_t* sem)
+{
+	// Masks SysTick and other kernel-aware ISRs at a higher priority than the caller
+	uint32_t basepri = k_crit_enter();
+	k_sem_give(sem);
+	k_crit_exit(basepri);
+}
+
+/********************
+ * 					*
+ * EVENT FLAGS		*
+ * 					*
+ ********************/
+
+// Flags that satisfy a wait, or 0 if the wait is not satisfied
+static uint32_t event_match(uint32_t flags, uint32_t wanted, uint32_t options)
+{
+	uint32_t match = flags & wanted;
+	if (options & OS_EVENT_WAIT_ALL) {
+		return (match == wanted) ? match : 0;
+	}
+	return match;
+}
+
+void k_event_set(k_event_t* event, uint32_t flags)
+{
+	event->flags |= flags;
+
+	// Every waiter sees the flags as set; auto-clears are applied after the pass
+	uint32_t clear = 0;
+	TCB* task = event->waiters.head;
+	while (task)
+	{
+		TCB* next = task->next_waiter;
+		uint32_t match = event_match(event->flags, task->wait_flags, task->wait_opts);
+		if (match)
+		{
+			if (task->wait_opts & OS_EVENT_AUTO_CLEAR) clear |= match;
+			task->wait_flags = match;
+			wait_wake(task, RTX_OK);
+			preempt_check(task);
+		}
+		task = next;
+	}
+	event->flags &= ~clear;
+}
+
+void k_event_wait(k_event_t* event, uint32_t flags, uint32_t options, uint32_t timeout)
+{
+	uint32_t match = event_match(event->flags, flags, options);
+	if (match)
+	{
+		if (options & OS_EVENT_AUTO_CLEAR) event->flags &= ~match;
+		current_task->wait_flags = match;
+		current_task->wait_result = RTX_OK;
+		return;
+	}
+
+	current_task->wait_flags = flags;
+	current_task->wait_opts = options;
+	if (timeout == 0)
+	{
+		current_task->wait_result = RTX_ERR;
+		return;
+	}
+	wait_block(&event->waiters, timeout);
+}
+
+void osEventInit(k_event_t* event)
+{
+	event->flags = 0;
+	event->waiters.head = NULL;
+	event->waiters.mutex = NULL;
+}
+
+uint32_t osEventSet(k_event_t* event, uint32_t flags)
+{
+	__DMB();
+	while (1) {
+		uint32_t old = __LDREXW(&event->flags);
+		if (event->waiters.head) {
+			__CLREX();
+			break;
+		}
+		if (__STREXW(old | flags, &event->flags) == 0) {
+			return old | flags;
+		}
+	}
+
+	__svc_arg2(SVC_EVENT_SET, event, flags);
+	return event->flags;
+}
+
+void osEventSetFromISR(k_event_t* event, uint32_t flags)
+{
+	uint32_t basepri = k_crit_enter();
+	k_event_set(event, flags);
+	k_crit_exit(basepri);
+}
+
+uint32_t osEventClear(k_event_t* event, uint32_t flags)
+{
+	uint32_t old;
+	do {
+		old = __LDREXW(&event->flags);
+	} while (__STREXW(old & ~flags, &event->flags));
+	__DMB();
+	return old;
+}
+
+int osEventWait(k_event_t* event, uint32_t flags, uint32_t options, uint32_t timeout, uint32_t* result)
+{
+	__svc_arg4(SVC_EVENT_WAIT, event, flags, options, timeout);
+	if (current_task->wait_result != RTX_OK) {
+		return RTX_ERR;
+	}
+
+	if (result) *result = current_task->wait_flags;
+	return RTX_OK;
+}
+
+/********************
+ * 					*
+ * MUTEX			*
+ * 					*
+ ********************/
+
+void reinherit_deadline(TCB* task)
+{
+	task->inherit_delta = 0;
+
+	for (k_mutex_t* m = task->held; m != NULL; m = m->next_held)
+	{
+		if (m->waiters.head) {
+			inherit_deadline(task, m->waiters.head->time_left);
+		}
+	}
+}
+
+// Give a task back its own deadline, then re-apply what it still inherits
+static void restore_deadline(TCB* task)
+{
+	task->time_left += task->inherit_delta;
+	reinherit_deadline(task);
+}
+
+void k_mutex_lock(k_mutex_t* mutex)
+{
+	// Released between the failed fast path and the SVC
+	if (mutex->owner == 0)
+	{
+		mutex->owner = (uint32_t)(uintptr_t)current_task;
+		mutex->next_held = current_task->held;
+		current_task->held = mutex;
+		current_task->wait_result = RTX_OK;
+		return;
+	}
+
+	TCB* owner = (TCB*)(uintptr_t)mutex->owner;
+	wait_block(&mutex->waiters, OS_WAIT_FOREVER);
+	if (current_task->state == BLOCKED) inherit_deadline(owner, current_task->time_left);
+}
+
+// Pass a released mutex to its first waiter, or leave it free
+static void mutex_hand_off(k_mutex_t* mutex)
+{
+	TCB* next = wait_wake_one(&mutex->waiters, RTX_OK);
+	if (next == NULL)
+	{
+		mutex->owner = 0;
+	}
+	else
+	{
+		// Direct handoff: the woken task already owns the mutex when it runs
+		mutex->owner = (uint32_t)(uintptr_t)next;
+		mutex->next_held = next->held;
+		next->held = mutex;
+		if (mutex->waiters.head) {
+			inherit_deadline(next, mutex->waiters.head->time_left);
+		}
+	}
+}
+
+void k_mutex_unlock(k_mutex_t* mutex)
+{
+	current_task->wait_result = RTX_OK;
+	restore_deadline(current_task);
+	mutex_hand_off(mutex);
+
+	// Dropping an inherited deadline can also let another ready task run first
+	if (prio_q_size > 0) {
+		preempt_check(task_prio_q[1]);
+	}
+}
+
+void k_mutex_release_all(TCB* task)
+{
+	while (task->held != NULL)
+	{
+		k_mutex_t* mutex = task->held;
+		task->held = mutex->next_held;
+		mutex->next_held = NULL;
+		mutex_hand_off(mutex);
+	}
+	task->inherit_delta = 0;
+}
+
+void osMutexInit(k_mutex_t* mutex)
+{
+	mutex->owner = 0;
+	mutex->waiters.head = NULL;
+	mutex->waiters.mutex = mutex;
+	mutex->next_held = NULL;
+}
+
+int osMutexLock(k_mutex_t* mutex)
+{
+	uint32_t self = (uint32_t)(uintptr_t)current_task;
+
+	do {
+		uint32_t owner = __LDREXW(&mutex->owner);
+		if (owner == self) {
+			__CLREX();
+			return RTX_ERR;
+		}
+		if (owner != 0) {
+			__CLREX();
+			__svc_arg(SVC_MUTEX_LOCK, mutex);
+			return current_task->wait_result;
+		}
+	} while (__STREXW(self, &mutex->owner));
+	__DMB();
+
+	// Only the owner touches its held list outside the kernel
+	mutex->next_held = current_task->held;
+	current_task->held = mutex;
+	return RTX_OK;
+}
+
+int osMutexUnlock(k_mutex_t* mutex)
+{
+	uint32_t self = (uint32_t)(uintptr_t)current_task;
+	if (mutex->owner != self) {
+		return RTX_ERR;
+	}
+
+	// Unlink from the held list first so the kernel never re-inherits through it
+	k_mutex_t** link = &current_task->held;
+	while (*link != mutex) {
+		link = &(*link)->next_held;
+	}
+	*link = mutex->next_held;
+	mutex->next_held = NULL;
+
+	// A waiter arriving after LDREX goes through an SVC, which clears the
+	// exclusive monitor and makes the STREX fail
+	if (current_task->inherit_delta == 0) {
+		__DMB();
+		while (1) {
+			__LDREXW(&mutex->owner);
+			if (mutex->waiters.head) {
+				__CLREX();
+				break;
+			}
+			if (__STREXW(0, &mutex->owner) == 0) {
+				return RTX_OK;
+			}
+		}
+	}
+
+	__svc_arg(SVC_MUTEX_UNLOCK, mutex);
+	return current_task->wait_result;
+}
@@ -2,91 +2,324 @@
 #include "common.h"
 #include "k_task.h"
 #include "k_mem.h"
+#include "k_sync.h"
+#include "k_msgq.h"
+#include "k_trace.h"
+#include "k_idle.h"
+#include "k_sched_analysis.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
+
+#ifndef K_PORT_HOST
+// PendSV_Handler (svc.s) addresses stack_high directly
+_Static_assert(offsetof(TCB, stack_high) == 8, "TCB_STACK_HIGH in svc.s is out of date");
+#endif
 
-uint8_t SVC_RET;
-TCB* new_task;
-int new_deadline = 5;
 int timer = 1000;
 
-void SVC_Handler_Main(unsigned int *svc_args)
+// BASEPRI of kernel critical sections, also read by PendSV_Handler in svc.s
+const uint32_t kernel_basepri = KERNEL_CEILING << (8 - __NVIC_PRIO_BITS);
+
+// Stack shared by all run-to-completion jobs, see osCreateJob
+K_TASK_STACK(job_stack, JOB_STACK_SIZE);
+static TCB* job_top = NULL; // Most recently started job that has not returned
+
+// Room PendSV needs below a job's PSP to save R4-R11, EXC_RETURN and S16-S31
+#define JOB_CONTEXT_RESERVE ((9 + 16) * 4)
+
+static void job_start(TCB* job);
+static void heap_remove(TCB* task);
+static void period_release(TCB* task, uint32_t late);
+static int period_complete(TCB* task);
+static void period_start(TCB* task);
+static uint32_t task_density(TCB* task, uint32_t deadline);
+
+/*
+ * System calls. Arguments arrive in the caller's r0-r3, which the hardware
+ * stacked on exception entry (svc_args[0..3]); a handler returns a value by
+ * writing svc_args[0], which the caller sees in r0 after the SVC. Blocking
+ * calls report their result later through current_task->wait_result instead.
+ */
+
+static void svc_kernel_start(unsigned int *svc_args)
 {
-	/*
-	 * Stack contains:
-	 * r0, r1, r2, r3, r12, r14, the return address and xPSR
-	 * First argument (r0) is svc_args[0]
-	 */
-	unsigned int svc_number = ((char *)svc_args[6])[-2];
+	TCB* first = pop_task();
+	if (first->job == JOB_RELEASED) job_start(first);
+	period_start(first);
+	current_task = first;
+	current_task->state = RUNNING;
+	K_TRACE(K_TRACE_SWITCH, TID_NULL, current_task->tid);
+	cpu_stamp = DWT->CYCCNT;
+	set_stack_guard(current_task);
+	__set_PSP(current_task->stack_high);
+	__run_first_thread();
+}
 
-	switch (svc_number)
-	{
-	case SVC_KERNEL_START:
-		current_task = pop_task();
-		current_task->state = RUNNING;
-		__set_PSP(current_task->stack_high);
-		__run_first_thread();
-		break;
-	case SVC_KERNEL_YIELD:
-		current_task->state = READY;
-		current_task->time_left = current_task->deadline;
-		queue_task(current_task);
-		SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
-		__asm("isb");
-		break;
-	case SVC_KERNEL_EXIT:
-		current_task->state = DORMANT;
+static void svc_yield(unsigned int *svc_args)
+{
+	current_task->state = READY;
+	current_task->time_left = current_task->deadline;
+	queue_task(current_task);
+	reinherit_deadline(current_task);
+	SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+	__ISB();
+}
+
+static void svc_exit(unsigned int *svc_args)
+{
+	// Its waiters would block forever, and the next task in this slot would look like the owner
+	k_mutex_release_all(current_task);
+	current_task->state = DORMANT;
+	task_count--;
+	k_admit(task_density(current_task, current_task->deadline), 0);
+	if (current_task->job != JOB_NONE) {
+		// Its frame is the top of the shared stack
+		job_top = current_task->job_below;
+		current_task->job = JOB_NONE;
+	} else {
 		stack_used -= current_task->stack_size;
-		task_count--;
-		k_mem_dealloc(current_task->stack_bot);
-		SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
-		__asm("isb");
-		break;
-	case SVC_TASK_CREATE:
-		// Find an empty TCB in task_list
-		// Start at index 1 since index 0 is reserved for null task
-		TCB* real_cur_task = current_task;
-		for (int i = 1; i < MAX_TASKS; ++i)
+		if (!current_task->static_stack) k_mem_dealloc((void*)(uintptr_t)current_task->stack_bot);
+	}
+	SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+	__ISB();
+}
+
+// Create a task from a template, through SVC_TASK_CREATE or directly from osKernelInit.
+// stack is a caller-provided stack, or 0 to allocate one
+static int task_create(TCB* input, int deadline, uint32_t stack)
+{
+	int result;
+
+	// Find an empty TCB in task_list
+	// Start at index 1 since index 0 is reserved for null task
+	TCB* real_cur_task = current_task;
+	for (int i = 1; i < MAX_TASKS; ++i)
+	{
+		// If there is an empty entry in the TCB list a
+		if (task_list[i].state == DORMANT || task_list[i].state == UNINIT)
 		{
-			// If there is an empty entry in the TCB list a
-			if (task_list[i].state == DORMANT || task_list[i].state == UNINIT)
+			// A periodic task's deadline is at most its period, so budget / deadline is its density
+			uint32_t density = k_density(input->budget, deadline);
+			if (k_admit(0, density) != RTX_OK)
 			{
-				init_tcb(i, new_task, new_deadline);
-				queue_task(&task_list[i]);
-				new_deadline = 5;
-
-				// Make the task being created own stack initiziation
-				current_task = &task_list[i];
-				SVC_RET = init_t_stack(&task_list[i], new_task);
-				current_task = real_cur_task;
-				if (SVC_RET == RTX_ERR)
-				{
-					task_list[i].state = UNINIT;
-					return;
-				}
+				return RTX_ERR;
+			}
+			init_tcb(i, input, deadline);
 
-				if (task_list[i].time_left < current_task->time_left ||
-						(task_list[i].time_left == current_task->time_left
-								&& task_list[i].tid == current_task->tid))
-				{
-					current_task->state = READY;
-					queue_task(current_task);
-					SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
-					__asm("isb");
-				}
+			// Make the task being created own stack initiziation
+			current_task = &task_list[i];
+			result = init_t_stack(&task_list[i], input, stack);
+			current_task = real_cur_task;
+			if (result == RTX_ERR)
+			{
+				task_list[i].state = UNINIT;
+				stack_used -= input->stack_size;
+				task_count--;
+				k_admit(density, 0);
+				return RTX_ERR;
+			}
+			queue_task(&task_list[i]);
 
-				return;
+			// Tasks created before osKernelStart have no running task to preempt
+			if (current_task && (task_list[i].time_left < current_task->time_left ||
+					(task_list[i].time_left == current_task->time_left
+							&& task_list[i].tid == current_task->tid)))
+			{
+				current_task->state = READY;
+				queue_task(current_task);
+				SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+				__ISB();
 			}
+
+			return RTX_OK;
 		}
-		break;
-	case SVC_KERNEL_OS_SLEEP:
-		current_task->state = SLEEPING;
-		SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
-		__asm("isb");
-		break;
-	default:
-		break;
+	}
+	return RTX_ERR;
+}
+
+// svc_args[0]: TCB* template, svc_args[1]: deadline, svc_args[2]: static stack or 0
+static void svc_task_create(unsigned int *svc_args)
+{
+	svc_args[0] = task_create((TCB *)(uintptr_t)svc_args[0], (int)svc_args[1], svc_args[2]);
+}
+
+// svc_args[0]: sleep time in ms
+static void svc_sleep(unsigned int *svc_args)
+{
+	// A job keeps its frame on the shared stack until it returns, it cannot sleep
+	if (current_task->job != JOB_NONE) return;
+
+	current_task->sleep_time = svc_args[0];
+	current_task->state = SLEEPING;
+	SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+	__ISB();
+}
+
+// Round-trip benchmark: hands back its argument plus one
+static void svc_ping(unsigned int *svc_args)
+{
+	svc_args[0] += 1;
+}
+
+static void svc_mutex_lock(unsigned int *svc_args)
+{
+	k_mutex_lock((k_mutex_t *)(uintptr_t)svc_args[0]);
+}
+
+static void svc_mutex_unlock(unsigned int *svc_args)
+{
+	k_mutex_unlock((k_mutex_t *)(uintptr_t)svc_args[0]);
+}
+
+static void svc_sem_take(unsigned int *svc_args)
+{
+	k_sem_take((k_sem_t *)(uintptr_t)svc_args[0], svc_args[1]);
+}
+
+static void svc_sem_give(unsigned int *svc_args)
+{
+	k_sem_give((k_sem_t *)(uintptr_t)svc_args[0]);
+}
+
+static void svc_msgq_send(unsigned int *svc_args)
+{
+	k_msgq_send((k_msgq_t *)(uintptr_t)svc_args[0], (void *)(uintptr_t)svc_args[1], svc_args[2]);
+}
+
+static void svc_msgq_receive(unsigned int *svc_args)
+{
+	k_msgq_receive((k_msgq_t *)(uintptr_t)svc_args[0], svc_args[1]);
+}
+
+static void svc_event_set(unsigned int *svc_args)
+{
+	k_event_set((k_event_t *)(uintptr_t)svc_args[0], svc_args[1]);
+}
+
+static void svc_event_wait(unsigned int *svc_args)
+{
+	k_event_wait((k_event_t *)(uintptr_t)svc_args[0], svc_args[1], svc_args[2], svc_args[3]);
+}
+
+// svc_args[0]: TCB* template, svc_args[1]: period
+static void svc_job_create(unsigned int *svc_args)
+{
+	TCB* input = (TCB *)(uintptr_t)svc_args[0];
+	int period = (int)svc_args[1];
+	svc_args[0] = RTX_ERR;
+
+	for (int i = 1; i < MAX_TASKS; ++i)
+	{
+		if (task_list[i].state == DORMANT || task_list[i].state == UNINIT)
+		{
+			// No stack of its own: the shared one is reported for watermarks and the guard
+			init_tcb(i, input, period);
+			stack_used -= input->stack_size;
+			task_list[i].stack_bot = (uint32_t)(uintptr_t)job_stack;
+			task_list[i].stack_size = sizeof(job_stack);
+			task_list[i].stack_high = 0;
+			task_list[i].static_stack = 1;
+			task_list[i].job = JOB_RELEASED;
+			task_list[i].periodic.period = period;
+			task_list[i].periodic.next_release = k_ticks;
+			period_release(&task_list[i], 0);
+			input->stack_bot = task_list[i].stack_bot;
+
+			queue_task(&task_list[i]);
+			preempt_check(&task_list[i]);
+			svc_args[0] = RTX_OK;
+			return;
+		}
+	}
+}
+
+// The running job returned from its function
+static void svc_job_done(unsigned int *svc_args)
+{
+	if (current_task->job != JOB_STARTED) return;
+
+	// If it overran its period it is released again at once and stays on top of the shared stack
+	if (period_complete(current_task) == 0)
+	{
+		// Sleeps until the next release, the frame is dropped and rebuilt then
+		job_top = current_task->job_below;
+		current_task->job = JOB_RELEASED;
+	}
+	SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+	__ISB();
+}
+
+// svc_args[0]: TCB* template, svc_args[1]: period, svc_args[2]: deadline, svc_args[3]: phase
+static void svc_periodic_create(unsigned int *svc_args)
+{
+	TCB* input = (TCB *)(uintptr_t)svc_args[0];
+	uint32_t period = svc_args[1];
+	uint32_t phase = svc_args[3];
+	svc_args[0] = task_create(input, (int)svc_args[2], 0);
+	if (svc_args[0] != RTX_OK) return;
+
+	TCB* task = &task_list[input->tid];
+	task->periodic.period = period;
+	task->periodic.next_release = k_ticks + phase;
+	period_release(task, 0);
+	if (phase > 0)
+	{
+		// Out of the ready queue until the first release
+		heap_remove(task);
+		task->sleep_time = phase;
+		task->state = SLEEPING;
+	}
+}
+
+static void svc_period_wait(unsigned int *svc_args)
+{
+	if (current_task->periodic.period == 0 || current_task->job != JOB_NONE)
+	{
+		svc_args[0] = RTX_ERR;
+		return;
+	}
+
+	period_complete(current_task);
+	svc_args[0] = RTX_OK;
+	SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+	__ISB();
+}
+
+static void (* const svc_table[SVC_COUNT])(unsigned int *svc_args) = {
+	[SVC_PING] = svc_ping,
+	[SVC_KERNEL_START] = svc_kernel_start,
+	[SVC_KERNEL_YIELD] = svc_yield,
+	[SVC_KERNEL_EXIT] = svc_exit,
+	[SVC_TASK_CREATE] = svc_task_create,
+	[SVC_KERNEL_OS_SLEEP] = svc_sleep,
+	[SVC_MUTEX_LOCK] = svc_mutex_lock,
+	[SVC_MUTEX_UNLOCK] = svc_mutex_unlock,
+	[SVC_SEM_TAKE] = svc_sem_take,
+	[SVC_SEM_GIVE] = svc_sem_give,
+	[SVC_MSGQ_SEND] = svc_msgq_send,
+	[SVC_MSGQ_RECEIVE] = svc_msgq_receive,
+	[SVC_EVENT_SET] = svc_event_set,
+	[SVC_EVENT_WAIT] = svc_event_wait,
+	[SVC_JOB_CREATE] = svc_job_create,
+	[SVC_JOB_DONE] = svc_job_done,
+	[SVC_PERIODIC_CREATE] = svc_periodic_create,
+	[SVC_PERIOD_WAIT] = svc_period_wait,
+};
+
+void SVC_Handler_Main(unsigned int *svc_args)
+{
+	/*
+	 * Stack contains:
+	 * r0, r1, r2, r3, r12, r14, the return address and xPSR
+	 * First argument (r0) is svc_args[0]
+	 */
+	unsigned int svc_number = ((char *)(uintptr_t)svc_args[6])[-2];
+	K_TRACE(K_TRACE_SVC, current_task ? current_task->tid : TID_NULL, svc_number);
+
+	if (svc_number < SVC_COUNT && svc_table[svc_number]) {
+		svc_table[svc_number](svc_args);
 	}
 }
 
@@ -107,30 +340,53 @@ void init_tcb(size_t idx, TCB *input, int deadline)
 	task_list[idx].deadline = deadline;
 	task_list[idx].time_left = deadline;
 	task_list[idx].sleep_time = 0;
+	task_list[idx].cpu_cycles = 0;
+	task_list[idx].next_waiter = NULL;
+	task_list[idx].wait_q = NULL;
+	task_list[idx].inherit_delta = 0;
+	task_list[idx].held = NULL;
+	task_list[idx].job = JOB_NONE;
+	task_list[idx].periodic = (k_period_t){0};
+	task_list[idx].budget = input->budget;
 
 	input->tid = idx;
 	stack_used += input->stack_size;
 	task_count++;
 }
 
-int init_t_stack(TCB *task, TCB *input)
+int init_t_stack(TCB *task, TCB *input, uint32_t stack)
 {
-	task->stack_bot = k_mem_alloc(task->stack_size);
+	task->static_stack = (stack != 0);
+	task->stack_bot = stack ? stack : (uint32_t)(uintptr_t)k_mem_alloc(task->stack_size);
 	task->stack_high = task->stack_bot + task->stack_size;
 
 	input->stack_bot = task->stack_bot;
 	input->stack_high = task->stack_high;
-	if (task->stack_bot == (uint32_t) NULL) { return RTX_ERR; }
+	if (task->stack_bot == 0) { return RTX_ERR; }
 
-	uint32_t *ptr = (uint32_t *)task->stack_high;
-	*(--ptr) = 1 << 24;
-	*(--ptr) = (uint32_t)task->ptask;
-	for (int i = 0; i < 14; ++i)
+	paint_stack(task->stack_bot, task->stack_size);
+	task->stack_high = init_t_frame(task->stack_high, task->ptask);
+	return RTX_OK;
+}
+
+uint32_t init_t_frame(uint32_t stack_high, void (*ptask)(void* args))
+{
+	uint32_t *ptr = (uint32_t *)(uintptr_t)stack_high;
+	*(--ptr) = INITIAL_XPSR;
+	*(--ptr) = (uint32_t)(uintptr_t)ptask;
+	// LR, R12, R3-R0
+	for (int i = 0; i < 6; ++i)
 	{
 		*(--ptr) = 0xA;
 	}
-	task->stack_high = (uint32_t)ptr;
-	return RTX_OK;
+	// Tasks start without an FP context, so the first restore skips S16-S31
+	*(--ptr) = EXC_RETURN_THREAD_PSP;
+	// R11-R4
+	for (int i = 0; i < 8; ++i)
+	{
+		*(--ptr) = 0xA;
+	}
+	return (uint32_t)(uintptr_t)ptr;
 }
 
 uint8_t heap_swap_check(TCB* parent, TCB* child)
@@ -147,6 +403,8 @@ void queue_task(TCB *task)
 		return;
 	}
 
+	K_TRACE(K_TRACE_READY, task->tid,
+			task->time_left > K_TRACE_ARG_MAX ? K_TRACE_ARG_MAX : task->time_left);
 	size_t cur = ++prio_q_size;
 	task_prio_q[cur] = task;
 
@@ -196,6 +454,7 @@ TCB *pop_task()
 			break;
 		}
 	}
+	K_TRACE(K_TRACE_POP, top->tid, prio_q_size);
 	return top;
 }
 
@@ -252,30 +511,85 @@ void update_heap(task_t TID) {
     }
 }
 
-int run_scheduler()
+// Take a task out of the ready queue wherever it is, no-op if it is not queued
+static void heap_remove(TCB* task)
+{
+	for (int i = 1; i <= prio_q_size; ++i) {
+		if (task_prio_q[i] == task) {
+			task_prio_q[i] = task_prio_q[prio_q_size];
+			task_prio_q[prio_q_size--] = NULL;
+			if (i <= prio_q_size) update_heap(task_prio_q[i]->tid);
+			return;
+		}
+	}
+}
+
+TCB *peek_task()
 {
-	// Account for R4-R11
-	current_task->stack_high = (uint32_t *)(__get_PSP() - 8 * sizeof(uint32_t));
+	return (prio_q_size == 0) ? &task_list[0] : task_prio_q[1];
+}
 
-	// Set PSP to next task
-	TCB *next_task = pop_task();
-	if (next_task != NULL)
+void preempt_check(TCB* task)
+{
+	// current_task is only RUNNING until the first preemption in this kernel entry.
+	// Any task beats the null task, whatever its time_left.
+	if (current_task && current_task->state == RUNNING
+			&& (current_task->tid == TID_NULL || heap_swap_check(current_task, task)))
 	{
-		next_task->state = RUNNING;
-		current_task = next_task;
-		__set_PSP(next_task->stack_high);
+		current_task->state = READY;
+		if (current_task->tid != TID_NULL) queue_task(current_task);
+		SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
+		__ISB();
+	}
+}
 
-		return RTX_OK;
+TCB *run_scheduler()
+{
+	TCB *next_task = peek_task();
+	if (next_task->job == JOB_STARTED && next_task != job_top)
+	{
+		// A job preempted on the shared stack resumes only after the jobs started
+		// above it have returned, the topmost one runs first (jobs never block)
+		next_task = job_top;
+		heap_remove(next_task);
 	}
 	else
 	{
-		return RTX_ERR;
+		pop_task();
 	}
+
+	period_start(next_task);
+
+	// Fast path: the running task still has the earliest deadline (e.g. it
+	// yielded and was queued again), so PendSV can return without a switch
+	if (next_task == current_task)
+	{
+		current_task->state = RUNNING;
+		return NULL;
+	}
+
+	account_cycles(current_task);
+
+	// PendSV_Handler saves the context, moves the stack guard and updates current_task
+	next_task->state = RUNNING;
+	if (next_task->job == JOB_RELEASED) job_start(next_task);
+	K_TRACE(K_TRACE_SWITCH, current_task->tid, next_task->tid);
+	return next_task;
+}
+
+void switch_stack_guard(TCB* task)
+{
+	set_stack_guard(task);
 }
 
 void tick_time_left()
 {
 	if(kernel_init) {
+		k_ticks++;
+		K_TRACE(K_TRACE_TICK, current_task ? current_task->tid : TID_NULL, 0);
+		// Keeps every 32-bit delta far below a CYCCNT wrap
+		if (current_task) account_cycles(current_task);
+
 		uint8_t call_scheduler = 0;
 		for (int i = 1; i < MAX_TASKS; i++) {
 			if (task_list[i].state == READY || task_list[i].state == RUNNING) {
@@ -284,7 +598,10 @@ void tick_time_left()
 
 				if (task_list[i].state == RUNNING && task_list[i].time_left == 0)
 				{
-					task_list[i].time_left = task_list[i].deadline;
+					// An inherited deadline ran out: fall back to the task's own time left
+					task_list[i].time_left = task_list[i].inherit_delta ?
+							task_list[i].inherit_delta : task_list[i].deadline;
+					task_list[i].inherit_delta = 0;
 					call_scheduler = 1;
 				}
 			} else if (task_list[i].state == SLEEPING) {
@@ -293,6 +610,24 @@ void tick_time_left()
 				{
 					task_list[i].state = READY;
 					task_list[i].time_left = task_list[i].deadline;
+					if (task_list[i].periodic.period && !task_list[i].periodic.started) {
+						period_release(&task_list[i], 0);
+					}
+					queue_task(&task_list[i]);
+					// A mutex holder that slept keeps inheriting from the tasks waiting on it
+					reinherit_deadline(&task_list[i]);
+
+					call_scheduler = 1;
+				}
+			} else if (task_list[i].state == BLOCKED) {
+				// The absolute deadline keeps approaching while the task waits
+				task_list[i].time_left -= (task_list[i].time_left != 0);
+
+				if (task_list[i].sleep_time > 0 && --task_list[i].sleep_time == 0)
+				{
+					// Timed out: wait_result stays RTX_ERR
+					wait_remove(&task_list[i]);
+					task_list[i].state = READY;
 					queue_task(&task_list[i]);
 
 					call_scheduler = 1;
@@ -300,18 +635,163 @@ void tick_time_left()
 			}
 		}
 
-		if (call_scheduler) {
+		// Before osKernelStart there is no task to preempt; the start picks the woken ones
+		if (call_scheduler && current_task != NULL) {
 			current_task->state = READY; //Set current task to ready
 			if (current_task->tid != TID_NULL) queue_task(current_task);
 			SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
-			__asm("isb");
+			__ISB();
+		}
+	}
+}
+
+void tick_skip(uint32_t ticks)
+{
+	k_ticks += ticks;
+	for (int i = 1; i < MAX_TASKS; i++) {
+		if (task_list[i].state == SLEEPING) {
+			task_list[i].sleep_time -= ticks;
+		} else if (task_list[i].state == BLOCKED) {
+			task_list[i].time_left -= (task_list[i].time_left < ticks) ? task_list[i].time_left : ticks;
+			if (task_list[i].sleep_time > 0) task_list[i].sleep_time -= ticks;
+		}
+	}
+}
+
+/********************
+ * 					*
+ * JOBS				*
+ * 					*
+ ********************/
+
+// Every job release starts here, on the shared stack
+static void job_entry(void*)
+{
+	while (1) {
+		current_task->ptask(NULL);
+		__svc(SVC_JOB_DONE); // Only returns if the job was released again right away
+	}
+}
+
+// Build the first frame of a job release below the jobs already on the shared stack
+static void job_start(TCB* job)
+{
+	uint32_t base = job_top ? job_top->stack_high : (uint32_t)(uintptr_t)job_stack + sizeof(job_stack);
+	if (current_task && current_task->job != JOB_NONE)
+	{
+		// The job being switched out has yet to be saved by PendSV
+		uint32_t psp = __get_PSP() - JOB_CONTEXT_RESERVE;
+		if (psp < base) base = psp;
+	}
+
+	job->stack_high = init_t_frame(base & ~7U, job_entry);
+	job->job_below = job_top;
+	job->job = JOB_STARTED;
+	job_top = job;
+}
+
+/********************
+ * 					*
+ * PERIODIC TASKS	*
+ * 					*
+ ********************/
+
+// Start a job of a periodic task, late ms after its release on the grid
+static void period_release(TCB* task, uint32_t late)
+{
+	task->periodic.release_tick = k_ticks - late;
+	task->periodic.release_cycles = DWT->CYCCNT - late * (SystemCoreClock / 1000);
+	task->periodic.started = 0;
+}
+
+// The task is about to run: the first time since a release, that is the job's start
+static void period_start(TCB* task)
+{
+	k_period_t* p = &task->periodic;
+	if (p->period && !p->started)
+	{
+		uint32_t jitter = DWT->CYCCNT - p->release_cycles;
+		if (jitter > p->jitter_max) p->jitter_max = jitter;
+		p->started = 1;
+	}
+}
+
+// Account the job that just completed and move to the next release on the grid.
+// The task sleeps until then, or if it is already due it is queued again and 1 is returned.
+static int period_complete(TCB* task)
+{
+	k_period_t* p = &task->periodic;
+	uint32_t response = DWT->CYCCNT - p->release_cycles;
+	p->jobs++;
+	p->response_last = response;
+	if (response > p->response_max) p->response_max = response;
+	if (k_ticks - p->release_tick > task->deadline) p->misses++;
+
+	p->next_release += p->period;
+	int32_t wait = (int32_t)(p->next_release - k_ticks);
+	if (wait > 0)
+	{
+		p->started = 0;
+		task->sleep_time = wait;
+		task->state = SLEEPING;
+		return 0;
+	}
+
+	// Its absolute deadline still counts from the release it missed
+	uint32_t late = -wait;
+	task->time_left = (late < task->deadline) ? task->deadline - late : 0;
+	task->state = READY;
+	period_release(task, late);
+	queue_task(task);
+	reinherit_deadline(task);
+	return 1;
+}
+
+// Density the task holds in admission control with the given relative deadline.
+// A periodic task whose deadline was moved past its period is bounded by budget / period
+static uint32_t task_density(TCB* task, uint32_t deadline)
+{
+	if (task->periodic.period != 0 && task->periodic.period < deadline)
+	{
+		deadline = task->periodic.period;
+	}
+	return k_density(task->budget, deadline);
+}
+
+void paint_stack(uint32_t stack_bot, uint32_t stack_size)
+{
+#if STACK_PAINT
+	uint32_t *ptr = (uint32_t *)(uintptr_t)stack_bot;
+	for (uint32_t i = 0; i < stack_size / sizeof(uint32_t); ++i)
+	{
+		ptr[i] = STACK_PAINT_PATTERN;
+	}
+#endif
+}
+
+void check_stacks(void)
+{
+	for (int i = 0; i < MAX_TASKS; i++) {
+		if (task_list[i].state == UNINIT || task_list[i].state == DORMANT) continue;
+
+		uint32_t used = osTaskStackHighWater(i);
+		uint32_t usable = task_list[i].stack_bot + task_list[i].stack_size - stack_usable_bot(&task_list[i]);
+		if (used + STACK_WARN_MARGIN > usable) {
+			stack_warn_mask |= 1U << i;
 		}
 	}
 }
 
 void null_task(void*)
 {
-	while(1);
+	uint32_t last_check = HAL_GetTick();
+	while(1) {
+		if (STACK_PAINT && HAL_GetTick() - last_check >= STACK_CHECK_PERIOD) {
+			last_check = HAL_GetTick();
+			check_stacks();
+		}
+		k_idle();
+	}
 }
 
 /********************
@@ -330,12 +810,42 @@ uint8_t kernel_init = 0;
 TCB* task_prio_q[MAX_TASKS+1];
 uint8_t prio_q_size = 0;
 
+uint32_t k_ticks = 0;       // Kernel ticks since osKernelInit, the time base of periodic releases
+uint32_t cpu_stamp = 0;     // DWT->CYCCNT at the last accounting point
+uint64_t cpu_total = 0;     // Cycles accounted to all tasks since osKernelStart
+uint64_t load_total = 0;    // cpu_total at the last osGetCpuLoad call
+uint64_t load_idle = 0;     // Null task cycles at the last osGetCpuLoad call
+
+uint32_t stack_warn_mask = 0; // Tasks found close to overflowing by check_stacks
+
+extern const k_task_def_t _stask_table[], _etask_table[]; // K_TASK_DEFINE entries, from the linker script
+
 void osKernelInit()
 {
 	SHPR3 = (SHPR3 & ~(0xFFU << 24)) | (0xF0U << 24); // SysTick is lowest priority (highest number)
 	SHPR3 = (SHPR3 & ~(0xFFU << 16)) | (0xE0U << 16); // PendSV is in the middle
 
-	SHPR2 = (SHPR2 & ~(0xFFU << 24)) | (0xD0U << 24); // SVC is highest priority (lowest number)
+	SHPR2 = (SHPR2 & ~(0xFFU << 24)) | (kernel_basepri << 24); // SVC is highest priority (lowest number), at the kernel ceiling
+
+#if (__FPU_USED == 1U)
+	// Automatic FP state preservation with lazy stacking: S0-S15 are only written
+	// to a task's frame if the exception handler itself touches the FPU
+	FPU->FPCCR |= FPU_FPCCR_ASPEN_Msk | FPU_FPCCR_LSPEN_Msk;
+#endif
+
+	// Cycle counter used for per-task CPU accounting
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	osTraceStart();
+
+#if STACK_GUARD
+	// Only the stack guard region is programmed, the default map covers everything else
+	MPU->CTRL = MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+	SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk;
+	__DSB();
+	__ISB();
+#endif
 
 	kernel_init = 1;
 	k_mem_init();
@@ -345,18 +855,13 @@ void osKernelInit()
 	task_list[0].stack_size = MIN_STACK_SIZE;
 	task_list[0].tid = TID_NULL;
 	task_list[0].state = READY;
+	task_list[0].cpu_cycles = 0;
 
-	task_list[0].stack_bot = k_mem_alloc(task_list[0].stack_size);
+	task_list[0].stack_bot = (uint32_t)(uintptr_t)k_mem_alloc(task_list[0].stack_size);
 	task_list[0].stack_high = task_list[0].stack_bot + task_list[0].stack_size;
+	paint_stack(task_list[0].stack_bot, task_list[0].stack_size);
 
-	uint32_t *ptr = (uint32_t *)task_list[0].stack_high;
-	*(--ptr) = 1 << 24;
-	*(--ptr) = (uint32_t)task_list[0].ptask;
-	for (int i = 0; i < 14; ++i)
-	{
-		*(--ptr) = 0xA;
-	}
-	task_list[0].stack_high = (uint32_t)ptr;
+	task_list[0].stack_high = init_t_frame(task_list[0].stack_high, task_list[0].ptask);
 
 	// Initialize all other task TCB
 	for (int i = 1; i < MAX_TASKS; ++i)
@@ -374,6 +879,20 @@ void osKernelInit()
 
 	for (int i = 0; i < MAX_TASKS; ++i) task_prio_q[i] = NULL;
 	prio_q_size = 0;
+	job_top = NULL;
+	paint_stack((uint32_t)(uintptr_t)job_stack, sizeof(job_stack));
+	k_ticks = 0;
+	k_admit_init();
+
+	// Tasks declared with K_TASK_DEFINE: built here, READY before osKernelStart
+	for (const k_task_def_t* def = _stask_table; def < _etask_table; def++)
+	{
+		TCB task;
+		task.ptask = def->ptask;
+		task.stack_size = def->stack_size;
+		task.budget = def->budget;
+		*def->tid = (task_create(&task, def->deadline, (uint32_t)(uintptr_t)def->stack) == RTX_OK) ? task.tid : TID_INVALID;
+	}
 }
 
 int osKernelStart()
@@ -387,12 +906,13 @@ int osKernelStart()
 		return RTX_ERR;
 	}
 
-	__asm("SVC #1");
+	__svc(SVC_KERNEL_START);
+	return RTX_ERR;
 }
 
 void osYield()
 {
-	__asm("SVC #2");
+	__svc(SVC_KERNEL_YIELD);
 }
 
 int osCreateTask(TCB *task)
@@ -406,9 +926,8 @@ int osCreateTask(TCB *task)
 		return RTX_ERR;
 	}
 
-	new_task = task;
-	__asm("SVC #5");
-	return SVC_RET;
+	task->budget = 0;
+	return __svc_arg3(SVC_TASK_CREATE, task, 5, 0);
 }
 
 int osTaskInfo(task_t TID, TCB *task_copy)
@@ -430,10 +949,74 @@ int osTaskInfo(task_t TID, TCB *task_copy)
 	task_copy->deadline = task_list[TID].deadline;
 	task_copy->time_left = task_list[TID].time_left;
 	task_copy->sleep_time = task_list[TID].sleep_time;
+	task_copy->cpu_cycles = task_list[TID].cpu_cycles;
+
+	return RTX_OK;
+}
+
+int osTaskCpuCycles(task_t TID, uint64_t* cycles)
+{
+	if (TID >= MAX_TASKS || task_list[TID].state == UNINIT || cycles == NULL)
+	{
+		return RTX_ERR;
+	}
+
+	// The 64-bit counters are updated from SysTick and PendSV
+	uint32_t basepri = k_crit_enter();
+	if (current_task) account_cycles(current_task);
+	*cycles = task_list[TID].cpu_cycles;
+	k_crit_exit(basepri);
 
 	return RTX_OK;
 }
 
+uint32_t osTaskStackHighWater(task_t TID)
+{
+#if STACK_PAINT
+	if (TID >= MAX_TASKS || task_list[TID].state == UNINIT || task_list[TID].state == DORMANT)
+	{
+		return 0;
+	}
+
+	uint32_t *ptr = (uint32_t *)(uintptr_t)stack_usable_bot(&task_list[TID]);
+	uint32_t *end = (uint32_t *)(uintptr_t)(task_list[TID].stack_bot + task_list[TID].stack_size);
+	while (ptr < end && *ptr == STACK_PAINT_PATTERN)
+	{
+		ptr++;
+	}
+	return (end - ptr) * sizeof(uint32_t);
+#else
+	return 0;
+#endif
+}
+
+uint32_t osGetStackWarnings(void)
+{
+	return stack_warn_mask;
+}
+
+int osGetCpuLoad(void)
+{
+	uint32_t basepri = k_crit_enter();
+	if (current_task) account_cycles(current_task);
+	uint64_t total = cpu_total - load_total;
+	uint64_t idle = task_list[TID_NULL].cpu_cycles - load_idle;
+	load_total = cpu_total;
+	load_idle = task_list[TID_NULL].cpu_cycles;
+	k_crit_exit(basepri);
+
+	if (total == 0)
+	{
+		return 0;
+	}
+	return (int)(((total - idle) * 100) / total);
+}
+
+int osGetUtilization(void)
+{
+	return (int)(((uint64_t)k_density_total() * 100 + DENSITY_ONE - 1) / DENSITY_ONE);
+}
+
 task_t osGetTID(void)
 {
 	if (current_task == NULL)
@@ -445,20 +1028,18 @@ task_t osGetTID(void)
 
 int osTaskExit(void)
 {
-	__asm("SVC #3");
+	__svc(SVC_KERNEL_EXIT);
 
 	return RTX_OK;
 }
 
 void osSleep(int timeInMs)
 {
-	current_task->sleep_time = timeInMs;
-	__asm("SVC #6");
+	__svc_arg(SVC_KERNEL_OS_SLEEP, timeInMs);
 }
 
 void osPeriodYield(void) {
-	current_task->sleep_time = current_task->time_left;
-	__asm("SVC #6");
+	__svc_arg(SVC_KERNEL_OS_SLEEP, current_task->time_left);
 }
 
 int osSetDeadline(int deadline, task_t TID) {
@@ -467,45 +1048,47 @@ int osSetDeadline(int deadline, task_t TID) {
 		TID >= MAX_TASKS || 
 		TID == TID_NULL || 
 		TID == current_task->tid || 
-		task_list[TID].tid == TID_NULL ||
-		task_list[TID].state != READY) {
+		task_list[TID].tid == TID_NULL) {
 		return RTX_ERR;
 	}
 	
-	// Block interrupts
-	__disable_irq();
+	// Mask the kernel (SysTick, PendSV and kernel-aware ISRs) while the heap is changed
+	uint32_t basepri = k_crit_enter();
+
+	if (task_list[TID].state != READY) {
+		k_crit_exit(basepri);
+		return RTX_ERR;
+	}
+
+	// A task with a budget keeps its admission only if the new density fits
+	if (k_admit(task_density(&task_list[TID], task_list[TID].deadline),
+			task_density(&task_list[TID], deadline)) != RTX_OK) {
+		k_crit_exit(basepri);
+		return RTX_ERR;
+	}
 
 	task_list[TID].deadline = deadline;
 	task_list[TID].time_left = deadline;
 	
 	// Will need to remove task from queue and reinsert it to maintain priority
 	update_heap(TID);
+	reinherit_deadline(&task_list[TID]);
 
-	// Must check if TID task needs to be moved in the queue (preempted)
-	int preempt = 0;
-
-    if (prio_q_size > 0 && 
-        (task_prio_q[1]->time_left < current_task->time_left || 
-        (task_prio_q[1]->time_left == current_task->time_left && 
-         task_prio_q[1]->tid < current_task->tid))) {
-        preempt = 1;
-    }
-
-	// Enable interrupts
-	__enable_irq();
-
-	// If it does need to be preempted, trigger context switch
-	// Same as for Kernel Yield? Copied down, without the deadline check
-	if (preempt) {
-		current_task->state = READY;
-		queue_task(current_task);
-		SCB->ICSR |= SCB_ICSR_PENDSVSET_Msk; // Calling PendSV
-		__asm("isb");
+	// Pends PendSV if TID now beats the running task, it runs when the section ends
+	if (prio_q_size > 0) {
+		preempt_check(task_prio_q[1]);
 	}
+
+	k_crit_exit(basepri);
 	return RTX_OK;
 }
 
 int osCreateDeadlineTask(int deadline, TCB* task)
+{
+	return osCreateDeadlineTaskBudget(deadline, 0, task);
+}
+
+int osCreateDeadlineTaskBudget(int deadline, int budget, TCB* task)
 {
 	if (task_count >= MAX_TASKS)
 	{
@@ -519,9 +1102,102 @@ int osCreateDeadlineTask(int deadline, TCB* task)
 	{
 		return RTX_ERR;
 	}
+	if (budget < 0 || budget > deadline)
+	{
+		return RTX_ERR;
+	}
+
+	task->budget = budget;
+	return __svc_arg3(SVC_TASK_CREATE, task, deadline, 0);
+}
+
+int osCreateTaskStatic(TCB* task, void* stack, uint32_t stack_size, int deadline, int budget)
+{
+	if (task_count >= MAX_TASKS)
+	{
+		return RTX_ERR;
+	}
+	if (stack == NULL || ((uint32_t)(uintptr_t)stack % 8) != 0)
+	{
+		return RTX_ERR;
+	}
+	if ((stack_size % 8) != 0 || stack_size < MIN_STACK_SIZE || stack_size > MAX_STACK_SIZE)
+	{
+		return RTX_ERR;
+	}
+	if (deadline <= 0)
+	{
+		return RTX_ERR;
+	}
+	if (budget < 0 || budget > deadline)
+	{
+		return RTX_ERR;
+	}
+
+	task->stack_size = stack_size;
+	task->budget = budget;
+	return __svc_arg3(SVC_TASK_CREATE, task, deadline, stack);
+}
+
+int osCreatePeriodicTask(int period, int deadline, int budget, int phase, TCB* task)
+{
+	if (task_count >= MAX_TASKS)
+	{
+		return RTX_ERR;
+	}
+	if ((task->stack_size % 8) != 0)
+	{
+		return RTX_ERR;
+	}
+	if (period <= 0 || deadline <= 0 || deadline > period || phase < 0)
+	{
+		return RTX_ERR;
+	}
+	if (budget < 0 || budget > deadline)
+	{
+		return RTX_ERR;
+	}
+
+	task->budget = budget;
+	return __svc_arg4(SVC_PERIODIC_CREATE, task, period, deadline, phase);
+}
+
+int osWaitNextPeriod(void)
+{
+	return __svc(SVC_PERIOD_WAIT);
+}
+
+int osPeriodStats(task_t TID, k_period_t* stats)
+{
+	if (TID >= MAX_TASKS || task_list[TID].state == UNINIT || task_list[TID].state == DORMANT
+			|| task_list[TID].periodic.period == 0)
+	{
+		return RTX_ERR;
+	}
 
-	new_task = task;
-	new_deadline = deadline;
-	__asm("SVC #5");
-	return SVC_RET;
+	// Updated by SysTick and PendSV
+	uint32_t basepri = k_crit_enter();
+	*stats = task_list[TID].periodic;
+	k_crit_exit(basepri);
+	return RTX_OK;
+}
+
+int osCreateJob(TCB* job, int period)
+{
+	if (task_count >= MAX_TASKS)
+	{
+		return RTX_ERR;
+	}
+	if (period <= 0)
+	{
+		return RTX_ERR;
+	}
+
+	job->budget = 0;
+	return __svc_arg2(SVC_JOB_CREATE, job, period);
+}
+
+int osSyscallPing(int value)
+{
+	return __svc_arg(SVC_PING, value);
 }
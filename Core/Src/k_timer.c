@@ -0,0 +1,203 @@
+#include "main.h"
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+#include "k_timer.h"
+
+#include <stddef.h>
+
+static k_timer_t* wheel[TIMER_WHEEL_SIZE];
+static k_timer_t* expired;          // Expired timers waiting for the daemon, oldest first
+static volatile uint32_t timer_ticks;
+static k_sem_t daemon_sem;
+static uint8_t daemon_created = 0;
+
+// Append to a circular list, O(1)
+static void timer_link(k_timer_t** list, k_timer_t* t)
+{
+	k_timer_t* head = *list;
+	if (head == NULL)
+	{
+		t->next = t;
+		t->prev = t;
+		*list = t;
+	}
+	else
+	{
+		t->next = head;
+		t->prev = head->prev;
+		head->prev->next = t;
+		head->prev = t;
+	}
+	t->list = list;
+}
+
+static void timer_unlink(k_timer_t* t)
+{
+	k_timer_t** list = t->list;
+	if (list == NULL) {
+		return;
+	}
+
+	if (t->next == t)
+	{
+		*list = NULL;
+	}
+	else
+	{
+		t->prev->next = t->next;
+		t->next->prev = t->prev;
+		if (*list == t) *list = t->next;
+	}
+	t->list = NULL;
+}
+
+static void timer_arm(k_timer_t* t, uint32_t expires)
+{
+	t->expires = expires;
+	timer_link(&wheel[expires & (TIMER_WHEEL_SIZE - 1)], t);
+}
+
+void k_timer_tick(void)
+{
+	uint32_t now = ++timer_ticks;
+	k_timer_t* t = wheel[now & (TIMER_WHEEL_SIZE - 1)];
+	if (t == NULL) {
+		return;
+	}
+
+	// Timers due on a later turn of the wheel share the slot and stay put
+	uint8_t wake = (expired == NULL);
+	k_timer_t* last = t->prev;
+	while (1)
+	{
+		k_timer_t* next = t->next;
+		uint8_t done = (t == last);
+		if (t->expires == now)
+		{
+			timer_unlink(t);
+			timer_link(&expired, t);
+		}
+		if (done) break;
+		t = next;
+	}
+
+	// The daemon drains the whole list per wakeup, so only signal it when the list fills
+	if (wake && expired) {
+		k_sem_give(&daemon_sem);
+	}
+}
+
+void k_timer_skip(uint32_t ticks)
+{
+	timer_ticks += ticks;
+}
+
+static void timer_daemon(void*)
+{
+	while (1)
+	{
+		osSemaphoreTake(&daemon_sem, OS_WAIT_FOREVER);
+		while (1)
+		{
+			uint32_t basepri = k_crit_enter();
+			k_timer_t* t = expired;
+			if (t)
+			{
+				timer_unlink(t);
+				if (t->period)
+				{
+					// Reload from the scheduled expiry so the period does not drift
+					uint32_t next = t->expires + t->period;
+					if ((int32_t)(next - timer_ticks) <= 0) next = timer_ticks + 1;
+					timer_arm(t, next);
+				}
+			}
+			k_crit_exit(basepri);
+
+			if (t == NULL) break;
+			t->callback(t->arg);
+		}
+	}
+}
+
+int osTimerCreate(k_timer_t* timer, k_timer_cb_t callback, void* arg)
+{
+	if (callback == NULL) {
+		return RTX_ERR;
+	}
+
+	if (!daemon_created)
+	{
+		osSemaphoreInit(&daemon_sem, 0);
+
+		TCB daemon;
+		daemon.stack_size = TIMER_DAEMON_STACK;
+		daemon.ptask = &timer_daemon;
+		if (osCreateDeadlineTask(TIMER_DAEMON_DEADLINE, &daemon) != RTX_OK) {
+			return RTX_ERR;
+		}
+		daemon_created = 1;
+	}
+
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->list = NULL;
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->period = 0;
+	timer->expires = 0;
+	return RTX_OK;
+}
+
+int osTimerStart(k_timer_t* timer, uint32_t delay, uint32_t period)
+{
+	if (delay == 0) {
+		return RTX_ERR;
+	}
+
+	uint32_t basepri = k_crit_enter();
+	timer_unlink(timer);
+	timer->period = period;
+	timer_arm(timer, timer_ticks + delay);
+	k_crit_exit(basepri);
+	return RTX_OK;
+}
+
+int osTimerStop(k_timer_t* timer)
+{
+	int ret = RTX_ERR;
+
+	uint32_t basepri = k_crit_enter();
+	if (timer->list) {
+		timer_unlink(timer);
+		ret = RTX_OK;
+	}
+	k_crit_exit(basepri);
+	return ret;
+}
+
+int osTimerIsActive(k_timer_t* timer)
+{
+	return timer->list != NULL;
+}
+
+uint32_t k_timer_next(void)
+{
+	if (expired) {
+		return 0;
+	}
+
+	uint32_t next = UINT32_MAX;
+	for (int i = 0; i < TIMER_WHEEL_SIZE; i++)
+	{
+		k_timer_t* t = wheel[i];
+		if (t == NULL) continue;
+		do {
+			uint32_t left = t->expires - timer_ticks;
+			if (left < next) next = left;
+			t = t->next;
+		} while (t != wheel[i]);
+	}
+	return next;
+}
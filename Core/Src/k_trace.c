@@ -0,0 +1,24 @@
+#include "main.h"
+#include "common.h"
+#include "k_trace.h"
+
+#if TRACE_ENABLE
+
+k_trace_t k_trace;
+
+void osTraceStart(void)
+{
+	k_trace.enabled = 0;
+	k_trace.magic = K_TRACE_MAGIC;
+	k_trace.count = 0;
+	k_trace.size = TRACE_RECORDS;
+	k_trace.clock = SystemCoreClock;
+	k_trace.enabled = 1;
+}
+
+void osTraceStop(void)
+{
+	k_trace.enabled = 0;
+}
+
+#endif /* TRACE_ENABLE */
@@ -0,0 +1,136 @@
+#include "main.h"
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+#include "k_work.h"
+
+#include <stddef.h>
+
+static k_work_t* volatile work_head = NULL;  // LIFO of submitted items
+static k_sem_t work_sem;
+static uint8_t work_created = 0;
+
+// Claim the item and push it, returns 1 if the queue was empty before
+static int work_push(k_work_t* work)
+{
+	uint32_t pending;
+	do {
+		pending = __LDREXW(&work->pending);
+		if (pending) {
+			__CLREX();
+			work->coalesced++;
+			return -1;
+		}
+	} while (__STREXW(1, &work->pending));
+
+	work->submitted = DWT->CYCCNT;
+
+	k_work_t* head;
+	do {
+		head = (k_work_t*)(uintptr_t)__LDREXW((volatile uint32_t*)&work_head);
+		work->next = head;
+	} while (__STREXW((uint32_t)(uintptr_t)work, (volatile uint32_t*)&work_head));
+	__DMB();
+
+	return head == NULL;
+}
+
+static void work_run(k_work_t* work)
+{
+	uint32_t latency = DWT->CYCCNT - work->submitted;
+	if (work->runs == 0 || latency < work->latency_min) work->latency_min = latency;
+	if (latency > work->latency_max) work->latency_max = latency;
+	work->latency_sum += latency;
+	work->runs++;
+
+	// Clear before running so a submit during fn queues it again
+	__DMB();
+	work->pending = 0;
+	work->fn(work->arg);
+}
+
+static void work_task(void*)
+{
+	while (1)
+	{
+		osSemaphoreTake(&work_sem, OS_WAIT_FOREVER);
+
+		// Take the whole stack at once and reverse it into submit order
+		k_work_t* list;
+		do {
+			list = (k_work_t*)(uintptr_t)__LDREXW((volatile uint32_t*)&work_head);
+		} while (__STREXW(0, (volatile uint32_t*)&work_head));
+		__DMB();
+
+		k_work_t* fifo = NULL;
+		while (list)
+		{
+			k_work_t* next = list->next;
+			list->next = fifo;
+			fifo = list;
+			list = next;
+		}
+
+		while (fifo)
+		{
+			k_work_t* next = fifo->next;
+			work_run(fifo);
+			fifo = next;
+		}
+	}
+}
+
+int osWorkQueueCreate(int deadline)
+{
+	if (work_created) {
+		return RTX_ERR;
+	}
+
+	osSemaphoreInit(&work_sem, 0);
+
+	TCB worker;
+	worker.stack_size = WORKQ_STACK;
+	worker.ptask = &work_task;
+	if (osCreateDeadlineTask(deadline, &worker) != RTX_OK) {
+		return RTX_ERR;
+	}
+	work_created = 1;
+	return RTX_OK;
+}
+
+void osWorkInit(k_work_t* work, k_work_fn_t fn, void* arg)
+{
+	work->next = NULL;
+	work->fn = fn;
+	work->arg = arg;
+	work->pending = 0;
+	work->submitted = 0;
+	work->runs = 0;
+	work->coalesced = 0;
+	work->latency_min = 0;
+	work->latency_max = 0;
+	work->latency_sum = 0;
+}
+
+int osWorkSubmit(k_work_t* work)
+{
+	int was_empty = work_push(work);
+	if (was_empty < 0) {
+		return RTX_ERR;
+	}
+
+	// The task drains everything per wakeup, one give per empty -> non-empty is enough
+	if (was_empty) osSemaphoreGive(&work_sem);
+	return RTX_OK;
+}
+
+int osWorkSubmitFromISR(k_work_t* work)
+{
+	int was_empty = work_push(work);
+	if (was_empty < 0) {
+		return RTX_ERR;
+	}
+
+	if (was_empty) osSemaphoreGiveFromISR(&work_sem);
+	return RTX_OK;
+}
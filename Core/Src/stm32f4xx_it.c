@@ -24,6 +24,8 @@
 /* USER CODE BEGIN Includes */
 #include "common.h"
 #include "k_task.h"
+#include "k_timer.h"
+#include "k_trace.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -56,7 +58,8 @@
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
-
+extern DMA_HandleTypeDef hdma_usart2_tx;
+extern UART_HandleTypeDef huart2;
 /* USER CODE BEGIN EV */
 /* USER CODE END EV */
 
@@ -99,7 +102,21 @@ void HardFault_Handler(void)
 void MemManage_Handler(void)
 {
   /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
+  // Runs on MSP, so it is safe to report even though the task's stack is gone
+  uint32_t cfsr = SCB->CFSR;
+  uint32_t addr = SCB->MMFAR;
+  task_t tid = current_task ? current_task->tid : TID_NULL;
+
+  if (cfsr & SCB_CFSR_MSTKERR_Msk) {
+    // Exception entry stacking hit the guard, MMFAR is not valid
+    printf("MemManage: task %u overflowed its stack (fault while stacking)\r\n", tid);
+  } else if ((cfsr & SCB_CFSR_MMARVALID_Msk) && current_task &&
+             addr >= stack_guard_base(current_task) &&
+             addr < stack_guard_base(current_task) + STACK_GUARD_SIZE) {
+    printf("MemManage: task %u overflowed its stack at 0x%08lx\r\n", tid, addr);
+  } else {
+    printf("MemManage: task %u, CFSR 0x%08lx, MMFAR 0x%08lx\r\n", tid, cfsr, addr);
+  }
   /* USER CODE END MemoryManagement_IRQn 0 */
   while (1)
   {
@@ -175,7 +192,14 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  // The ready queue and timer wheel are also changed by kernel-aware ISRs
+  uint32_t basepri = k_crit_enter();
   tick_time_left();
+  k_timer_tick();
+#if LOG_ASYNC
+  log_retry();
+#endif
+  k_crit_exit(basepri);
     /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -186,6 +210,50 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/**
+  * @brief This function handles EXTI line[15:10] interrupts (B1 button).
+  *        Applications wake tasks from HAL_GPIO_EXTI_Callback with the
+  *        *FromISR kernel calls, so the NVIC priority must be KERNEL_IRQ_PRIORITY.
+  */
+void EXTI15_10_IRQHandler(void)
+{
+  K_TRACE_ISR_BEGIN();
+  HAL_GPIO_EXTI_IRQHandler(B1_Pin);
+  K_TRACE_ISR_END();
+}
+
+/**
+  * @brief This function handles DMA1 stream6 global interrupt (USART2 TX).
+  */
+void DMA1_Stream6_IRQHandler(void)
+{
+  K_TRACE_ISR_BEGIN();
+  HAL_DMA_IRQHandler(&hdma_usart2_tx);
+  K_TRACE_ISR_END();
+}
+
+/**
+  * @brief This function handles USART2 global interrupt.
+  */
+void USART2_IRQHandler(void)
+{
+  K_TRACE_ISR_BEGIN();
+  HAL_UART_IRQHandler(&huart2);
+  K_TRACE_ISR_END();
+}
+
+/**
+  * @brief This function handles the RTC wakeup timer (tickless idle) through EXTI line 22.
+  */
+void RTC_WKUP_IRQHandler(void)
+{
+  RTC->WPR = 0xCA;
+  RTC->WPR = 0x53;
+  RTC->ISR &= ~RTC_ISR_WUTF;
+  RTC->WPR = 0xFF;
+  EXTI->PR = EXTI_PR_PR22;
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
@@ -1,6 +1,6 @@
   .syntax unified
   .cpu cortex-m4
-  .fpu softvfp
+  .fpu fpv4-sp-d16
   .thumb
 
 .global SVC_Handler
@@ -15,27 +15,53 @@ SVC_Handler:
 .global __run_first_thread
 .thumb_func
 __run_first_thread:
-	POP {R7}
-	POP {R7}
+	LDR R0, =0xE000ED08			// VTOR: reset MSP to its initial value, main() never resumes
+	LDR R0, [R0]
+	LDR R0, [R0]
+	MSR MSP, R0
 	MRS R0, PSP
-  	LDMIA R0!,{R4-R11}
+  	LDMIA R0!,{R4-R11, LR}		// LR <- task's EXC_RETURN
   	MSR PSP, R0
-  	MOV LR, #0xFFFFFFFD
   	BX LR
 
+// Offset of stack_high in TCB, checked by a static assert in k_task.c
+.equ TCB_STACK_HIGH, 8
+
 .global PendSV_Handler
 .thumb_func
 PendSV_Handler:
-//	POP {R7}
-//	POP {R7}
+	MRS R3, BASEPRI				// Kernel-aware ISRs wait until current_task is switched
+	LDR R0, =kernel_basepri
+	LDR R0, [R0]
+	MSR BASEPRI_MAX, R0
+	PUSH {R3, LR}				// Saved BASEPRI, also keeps MSP 8-byte aligned
+	BL run_scheduler			// R4-R11 and S16-S31 are callee-saved, still the task's
+	POP {R3, LR}
+	CBNZ R0, switch_context
+	MSR BASEPRI, R3
+	BX LR						// Same task re-selected, nothing to save or restore
 
-	MRS R0, PSP
-  	STMDB R0!,{R4-R11}
+switch_context:
+	MRS R1, PSP
+	TST LR, #0x10				// EXC_RETURN bit 4 clear -> task has an FP context
+	IT EQ
+	VSTMDBEQ R1!,{S16-S31}		// S0-S15/FPSCR are stacked lazily by hardware
+	STMDB R1!,{R4-R11, LR}		// Deepest push of the outgoing stack, still under its guard
 
-	BL run_scheduler
-  	MRS R0, PSP
+	LDR R2, =current_task
+	LDR R12, [R2]
+	STR R1, [R12, #TCB_STACK_HIGH]
+	PUSH {R0, R3}
+	BL switch_stack_guard		// Guard moves only once the save is done
+	POP {R0, R3}
+	LDR R2, =current_task
+	STR R0, [R2]				// current_task = next task
+	LDR R1, [R0, #TCB_STACK_HIGH]
 
-	LDMIA R0!,{R4-R11}
-  	MOV LR, #0xFFFFFFFD
-	MSR PSP, R0
-  	BX LR
+	LDMIA R1!,{R4-R11, LR}
+	TST LR, #0x10
+	IT EQ
+	VLDMIAEQ R1!,{S16-S31}
+	MSR PSP, R1
+	MSR BASEPRI, R3
+	BX LR
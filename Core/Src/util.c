@@ -6,17 +6,149 @@
  */
 
 #include "main.h"
+#include "common.h"
+#include "k_task.h"
 
 //Needed for printf
 UART_HandleTypeDef huart2;
 
+#if LOG_ASYNC
+/*
+ * printf goes into log_buf and returns; USART2 TX DMA drains it in the
+ * background. Producers are serialized with a kernel critical section, the
+ * DMA completion only moves log_tail. When the ring is full the rest of the
+ * write is dropped and counted (binary KLOG records are dropped whole).
+ */
+static uint8_t log_buf[LOG_BUF_SIZE];
+static volatile uint32_t log_head = 0;  // Next byte to write
+static volatile uint32_t log_tail = 0;  // Next byte to send
+static volatile uint32_t log_len = 0;   // Bytes in flight, 0 when DMA is idle
+static volatile uint32_t log_dropped = 0;
+
+// Start the DMA on the contiguous run at log_tail, IRQs must be masked
+static void log_kick(void)
+{
+	if (log_len != 0 || log_head == log_tail) {
+		return;
+	}
+
+	uint32_t tail = log_tail & (LOG_BUF_SIZE - 1);
+	uint32_t len = log_head - log_tail;
+	if (len > LOG_BUF_SIZE - tail) len = LOG_BUF_SIZE - tail;
+
+	log_len = len;
+	if (HAL_UART_Transmit_DMA(&huart2, &log_buf[tail], len) != HAL_OK) {
+		// UART busy (e.g. a blocking HAL_UART_Transmit), log_retry starts it later
+		log_len = 0;
+	}
+}
+
+void log_retry(void)
+{
+	log_kick();
+}
+
+// Fault handlers run above the DMA interrupt: send everything by polling instead
+static void log_drain_polled(void)
+{
+	if (log_len) {
+		HAL_UART_AbortTransmit(&huart2); // The aborted run is sent again in full
+		log_len = 0;
+	}
+	while (log_tail != log_head) {
+		while (!(USART2->SR & USART_SR_TXE));
+		USART2->DR = log_buf[log_tail & (LOG_BUF_SIZE - 1)];
+		log_tail++;
+	}
+	while (!(USART2->SR & USART_SR_TC));
+}
+
+// Copy buf into the ring and start sending it. What does not fit is dropped,
+// all of it if whole is set. Returns the number of bytes queued
+static uint32_t log_put(const char* buf, uint32_t len, int whole)
+{
+	// Interrupts above KERNEL_CEILING must not printf
+	uint32_t basepri = k_crit_enter();
+
+	uint32_t room = LOG_BUF_SIZE - (log_head - log_tail);
+	uint32_t n = (len <= room) ? len : (whole ? 0 : room);
+	log_dropped += len - n;
+
+	uint32_t head = log_head;
+	for (uint32_t i = 0; i < n; i++) {
+		log_buf[(head + i) & (LOG_BUF_SIZE - 1)] = buf[i];
+	}
+	log_head = head + n;
+
+	uint32_t ipsr = __get_IPSR();
+	if (ipsr >= 2 && ipsr <= 6) {
+		log_drain_polled(); // NMI, HardFault, MemManage, BusFault, UsageFault
+	} else {
+		log_kick();
+	}
+
+	k_crit_exit(basepri);
+	return n;
+}
+
+int log_write(const char* buf, int len)
+{
+	log_put(buf, len, 0);
+	return len;
+}
+
+int log_write_all(const char* buf, int len)
+{
+	return (log_put(buf, len, 1) == (uint32_t)len) ? RTX_OK : RTX_ERR;
+}
+
+uint32_t log_dropped_count(void)
+{
+	return log_dropped;
+}
+
+uint32_t log_pending(void)
+{
+	return log_head - log_tail;
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance != USART2) {
+		return;
+	}
+
+	log_tail += log_len;
+	log_len = 0;
+	log_kick();
+}
+
+// Replaces the byte-at-a-time weak _write in syscalls.c
+int _write(int file, char *ptr, int len)
+{
+	(void)file;
+	return log_write(ptr, len);
+}
 
+int __io_putchar(int ch)
+{
+	char c = ch;
+	log_write(&c, 1);
+	return ch;
+}
+#else
 int __io_putchar(int ch)
 {
 	HAL_UART_Transmit(&huart2,&ch,1,HAL_MAX_DELAY);
 	return ch;
 }
 
+uint32_t log_pending(void)
+{
+	return 0;
+}
+#endif
+
 
 /**
   * @brief System Clock Configuration
@@ -0,0 +1,52 @@
+/*
+ * k_port_host.h
+ *
+ *      Kernel port hooks for the Linux build, included by k_task.h when
+ *      K_PORT_HOST is defined. See Host/Src/port.c.
+ *
+ *      Each task runs in its own ucontext on a host stack; the stack k_mem
+ *      allocates for it is still reserved and painted, but not used. SVC and
+ *      PendSV become function calls with SIGALRM (the 1 ms SysTick) blocked.
+ *      The kernel keeps addresses in 32-bit fields and syscall arguments, so
+ *      the port links with -no-pie and keeps every stack and the heap in .bss.
+ */
+#include <stdint.h>
+
+#ifndef HOST_K_PORT_HOST_H_
+#define HOST_K_PORT_HOST_H_
+
+#define HOST_HEAP_SIZE 0x10000          // Bytes between _img_end and HEAP_END
+#define HOST_STACK_SIZE 0x10000         // Host stack of every task and of main(); glibc printf alone needs several KB
+#define HOST_TIMEOUT_MS 10000           // Exit after this long even if tasks are still running
+#define HOST_IDLE_EXIT_MS 500           // Exit once a verdict was printed and only the null task ran this long
+
+extern uint32_t host_shpr[2];
+#define SHPR2 (host_shpr[0])
+#define SHPR3 (host_shpr[1])
+
+#define __set_pendsv() SCB->ICSR = 0x10000000
+
+// K_TASK_DEFINE table bounds: GNU ld provides these for k_task_table, port.c makes sure it exists
+#define _stask_table __start_k_task_table
+#define _etask_table __stop_k_task_table
+
+/**
+ * @brief Emulated SVC: builds an exception frame from the arguments, runs
+ *        SVC_Handler_Main and then PendSV if it was pended
+ * @return uint32_t r0 of the frame after the handler, like the target macros
+ */
+uint32_t host_svc(uint32_t svc_number, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3);
+
+#define __svc(svc_number) host_svc(svc_number, 0, 0, 0, 0)
+#define __svc_arg(svc_number, arg) \
+	host_svc(svc_number, (uint32_t)(uintptr_t)(arg), 0, 0, 0)
+#define __svc_arg2(svc_number, arg0, arg1) \
+	host_svc(svc_number, (uint32_t)(uintptr_t)(arg0), (uint32_t)(uintptr_t)(arg1), 0, 0)
+#define __svc_arg3(svc_number, arg0, arg1, arg2) \
+	host_svc(svc_number, (uint32_t)(uintptr_t)(arg0), (uint32_t)(uintptr_t)(arg1), \
+			(uint32_t)(uintptr_t)(arg2), 0)
+#define __svc_arg4(svc_number, arg0, arg1, arg2, arg3) \
+	host_svc(svc_number, (uint32_t)(uintptr_t)(arg0), (uint32_t)(uintptr_t)(arg1), \
+			(uint32_t)(uintptr_t)(arg2), (uint32_t)(uintptr_t)(arg3))
+
+#endif /* HOST_K_PORT_HOST_H_ */
@@ -0,0 +1,120 @@
+/*
+ * stm32f4xx_hal.h (host port)
+ *
+ *      Stands in for the STM32 HAL and CMSIS headers when the kernel is built
+ *      for Linux (K_PORT_HOST). Only what the kernel and the host-runnable
+ *      tests use is provided. Core registers the kernel writes once (priorities,
+ *      MPU, FPU, debug) are plain structs; the ones with behaviour are backed by
+ *      Host/Src/port.c:
+ *
+ *      DWT->CYCCNT     CLOCK_MONOTONIC scaled to SystemCoreClock (84 MHz)
+ *      SysTick->VAL    the same clock, since the last SysTick signal
+ *      SCB->ICSR       PENDSVSET is honoured when the last exception returns
+ *      BASEPRI/PRIMASK block the SysTick signal (SIGALRM)
+ *      LDREX/STREX     exclusive monitor cleared on every exception entry
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef HOST_STM32F4XX_HAL_H_
+#define HOST_STM32F4XX_HAL_H_
+
+#define __NVIC_PRIO_BITS 4
+#define __FPU_USED 0
+
+/* Core peripherals */
+typedef struct {
+	volatile uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR;
+	volatile uint8_t SHP[12];
+	volatile uint32_t SHCSR;
+} SCB_Type;
+
+typedef struct {
+	volatile uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	volatile uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+	volatile uint32_t TYPE, CTRL, RNR, RBAR, RASR;
+} MPU_Type;
+
+typedef struct {
+	volatile uint32_t CTRL, LOAD, VAL, CALIB;
+} SysTick_Type;
+
+typedef struct {
+	volatile uint32_t FPCCR, FPCAR, FPDSCR;
+} FPU_Type;
+
+extern SCB_Type host_scb;
+extern CoreDebug_Type host_coredebug;
+extern MPU_Type host_mpu;
+extern FPU_Type host_fpu;
+DWT_Type* host_dwt(void);
+SysTick_Type* host_systick(void);
+
+#define SCB (&host_scb)
+#define DWT (host_dwt())        // CYCCNT is refreshed on every access
+#define CoreDebug (&host_coredebug)
+#define MPU (&host_mpu)
+#define SysTick (host_systick())  // VAL counts down from LOAD since the last tick
+#define FPU (&host_fpu)
+
+#define SCB_ICSR_PENDSVSET_Msk (1UL << 28)
+#define SCB_SHCSR_MEMFAULTENA_Msk (1UL << 16)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define MPU_CTRL_ENABLE_Msk (1UL << 0)
+#define MPU_CTRL_PRIVDEFENA_Msk (1UL << 2)
+#define MPU_RBAR_VALID_Msk (1UL << 4)
+#define MPU_RASR_ENABLE_Msk (1UL << 0)
+#define MPU_RASR_SIZE_Pos 1U
+#define MPU_RASR_XN_Msk (1UL << 28)
+#define SysTick_CTRL_COUNTFLAG_Msk (1UL << 16)
+#define FPU_FPCCR_ASPEN_Msk (1UL << 31)
+#define FPU_FPCCR_LSPEN_Msk (1UL << 30)
+
+#define EXC_RETURN_THREAD_PSP (0xFFFFFFFDUL)
+
+/* Intrinsics */
+#define __ISB() __asm volatile("" ::: "memory")
+#define __DSB() __asm volatile("" ::: "memory")
+#define __DMB() __asm volatile("" ::: "memory")
+#define __WFI() host_wfi()
+
+void host_wfi(void);
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+uint32_t __get_BASEPRI(void);
+void __set_BASEPRI(uint32_t basepri);
+void __set_BASEPRI_MAX(uint32_t basepri);
+uint32_t __get_IPSR(void);
+void __set_PSP(uint32_t psp);
+uint32_t __get_PSP(void);
+uint32_t __LDREXW(volatile uint32_t* addr);
+uint32_t __STREXW(uint32_t value, volatile uint32_t* addr);
+void __CLREX(void);
+
+/* HAL */
+typedef enum {
+	HAL_OK = 0,
+	HAL_ERROR = 1
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+extern uint32_t SystemCoreClock;
+
+HAL_StatusTypeDef HAL_Init(void);
+void HAL_IncTick(void);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+void HAL_SuspendTick(void);
+void HAL_ResumeTick(void);
+
+#endif /* HOST_STM32F4XX_HAL_H_ */
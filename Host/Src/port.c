@@ -0,0 +1,542 @@
+/*
+ * Linux port of the kernel (K_PORT_HOST), see Host/Inc/k_port_host.h.
+ *
+ * Exception model: SIGALRM every millisecond is SysTick. It is blocked while
+ * the emulated PRIMASK/BASEPRI is set or an exception (SVC, PendSV, SysTick)
+ * is active, which gives the same nesting as the NVIC priorities on the target:
+ * SVC and kernel critical sections hold off SysTick, and a pended PendSV runs
+ * when the last of them ends. A context switch is a swapcontext() between the
+ * per-task host contexts; it may happen inside the signal handler, exactly
+ * where PendSV would tail-chain after SysTick.
+ */
+#define _GNU_SOURCE
+#include "main.h"
+#include "common.h"
+#include "k_task.h"
+#include "k_timer.h"
+#include "k_idle.h"
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#define XSTR(x) STR(x)
+#define STR(x) #x
+
+// k_mem.h puts the heap between _img_end and _estack - 0x4000 (the MSP area on the target)
+__asm__(".pushsection .bss\n"
+		"\t.balign 16\n"
+		"\t.globl _img_end\n"
+		"_img_end:\n"
+		"\t.space " XSTR(HOST_HEAP_SIZE) " + 0x4000\n"
+		"\t.globl _estack\n"
+		"_estack:\n"
+		"\t.popsection");
+
+// Empty k_task_table, so the linker defines its bounds when no test uses K_TASK_DEFINE
+__asm__(".pushsection k_task_table,\"a\"\n"
+		"\t.popsection");
+
+int host_app_main(void); // The test's main(), renamed by the Makefile
+
+SCB_Type host_scb;
+CoreDebug_Type host_coredebug;
+MPU_Type host_mpu;
+FPU_Type host_fpu;
+uint32_t host_shpr[2];
+uint32_t SystemCoreClock = 84000000;
+
+static DWT_Type host_dwt_regs;
+static SysTick_Type host_systick_regs;
+static uint64_t tick_ns;                     // Time of the last SysTick signal
+static volatile uint32_t uwTick = 0;
+static volatile uint32_t tick_suspended = 0;
+
+static volatile uint32_t host_primask = 0;
+static volatile uint32_t host_basepri = 0;
+static volatile uint32_t host_ipsr = 0;      // 0 thread, 11 SVC, 14 PendSV, 15 SysTick
+static volatile uint32_t* excl_addr = NULL;  // Exclusive monitor, see __LDREXW
+static uint32_t excl_value;
+static sigset_t tick_set;
+
+// Host stacks live in .bss so their addresses fit the kernel's 32-bit fields
+static uint8_t host_stacks[MAX_TASKS][HOST_STACK_SIZE] __attribute__((aligned(16)));
+static uint8_t main_stack[HOST_STACK_SIZE] __attribute__((aligned(16)));
+static ucontext_t host_ctx[MAX_TASKS];
+static void (*host_entry[MAX_TASKS])(void*); // PC of the frame a task was started from
+static ucontext_t boot_ctx, main_ctx;
+
+// SVC_Handler_Main reads the SVC number from the instruction before the stacked
+// PC; host_svc points the PC just past entry n, whose first byte is n (SVC #n)
+static uint8_t svc_insn[SVC_COUNT + 1][2];
+
+static volatile int verdict_pass = 0, verdict_fail = 0;
+static uint32_t idle_since = 0;
+static uint32_t timeout_ms = HOST_TIMEOUT_MS;
+
+/********************
+ * 					*
+ * EXCEPTIONS		*
+ * 					*
+ ********************/
+
+static uint64_t host_ns(void);
+
+static inline int host_masked(void)
+{
+	return host_primask || host_basepri || host_ipsr;
+}
+
+static void host_irq_update(void)
+{
+	sigprocmask(host_masked() ? SIG_BLOCK : SIG_UNBLOCK, &tick_set, NULL);
+}
+
+static void host_irq_block(void)
+{
+	sigprocmask(SIG_BLOCK, &tick_set, NULL);
+}
+
+static void host_task_entry(void);
+
+// Start a task whose stack still holds the frame init_t_frame built, otherwise false.
+// A job gets a new frame at every release and starts over on the same host stack.
+static int host_prepare(TCB* task)
+{
+	uint32_t* frame = (uint32_t*)(uintptr_t)task->stack_high;
+	if (frame[8] != EXC_RETURN_THREAD_PSP || frame[16] != INITIAL_XPSR) {
+		return 0;
+	}
+	frame[16] = 0; // Consumed, the next switch resumes the saved context
+	host_entry[task->tid] = (void (*)(void*))(uintptr_t)frame[15];
+
+	ucontext_t* ctx = &host_ctx[task->tid];
+	getcontext(ctx);
+	ctx->uc_stack.ss_sp = host_stacks[task->tid];
+	ctx->uc_stack.ss_size = HOST_STACK_SIZE;
+	ctx->uc_link = NULL;
+	sigemptyset(&ctx->uc_sigmask);
+	makecontext(ctx, host_task_entry, 0);
+	return 1;
+}
+
+static void host_task_entry(void)
+{
+	// Exception return into thread mode
+	host_ipsr = 0;
+	host_primask = 0;
+	host_basepri = 0;
+	host_irq_update();
+
+	host_entry[current_task->tid](NULL);
+	osTaskExit();
+}
+
+// PendSV_Handler: called with SIGALRM blocked, from the end of the last active exception
+static void host_pendsv(void)
+{
+	while ((host_scb.ICSR & SCB_ICSR_PENDSVSET_Msk) && !host_masked())
+	{
+		host_scb.ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+		host_ipsr = 14;
+
+		TCB* prev = current_task;
+		TCB* next = run_scheduler();
+		if (next) {
+			switch_stack_guard(next);
+			current_task = next;
+			host_prepare(next);
+			swapcontext(&host_ctx[prev->tid], &host_ctx[next->tid]);
+			// Resumed: prev is running again and its PendSV is returning
+		}
+		host_ipsr = 0;
+	}
+}
+
+// The masking level dropped: run PendSV if it became possible, then update the signal mask
+static void host_tail(void)
+{
+	if ((host_scb.ICSR & SCB_ICSR_PENDSVSET_Msk) && !host_masked()) {
+		host_irq_block();
+		host_pendsv();
+	}
+	host_irq_update();
+}
+
+uint32_t host_svc(uint32_t svc_number, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
+{
+	if (host_masked()) {
+		// On the target the SVC is masked too and escalates to HardFault
+		fprintf(stderr, "host: SVC %u with interrupts masked\n", svc_number);
+		abort();
+	}
+
+	// r0-r3, r12, lr, pc, xpsr
+	unsigned int frame[8] = { arg0, arg1, arg2, arg3, 0, 0,
+			(uint32_t)(uintptr_t)&svc_insn[svc_number + 1][0], INITIAL_XPSR };
+
+	host_irq_block();
+	host_ipsr = 11;
+	excl_addr = NULL;
+	SVC_Handler_Main(frame);
+	host_ipsr = 0;
+	host_tail();
+	return frame[0];
+}
+
+void __run_first_thread(void)
+{
+	// main() never resumes, as on the target where MSP is reset
+	host_prepare(current_task);
+	setcontext(&host_ctx[current_task->tid]);
+}
+
+static void host_finish(void)
+{
+	fflush(stdout);
+	fprintf(stderr, "host: %d PASS, %d FAIL%s\n", verdict_pass, verdict_fail,
+			(verdict_pass || verdict_fail) ? "" : " (no verdict printed)");
+	_exit(verdict_fail ? 1 : 0);
+}
+
+// Tests end by idling forever: stop once a verdict is out and only the null task runs
+static void host_watch(void)
+{
+	if ((!verdict_pass && !verdict_fail) || current_task != &task_list[TID_NULL]) {
+		idle_since = uwTick;
+	}
+	if (uwTick - idle_since >= HOST_IDLE_EXIT_MS || uwTick >= timeout_ms) {
+		host_finish();
+	}
+}
+
+// SysTick_Handler
+static void systick_handler(int sig)
+{
+	(void)sig;
+	if (tick_suspended) return;
+
+	host_ipsr = 15;
+	excl_addr = NULL;
+	tick_ns = host_ns();
+	HAL_IncTick();
+	// The ready queue and timer wheel are also changed by kernel-aware ISRs
+	uint32_t basepri = k_crit_enter();
+	tick_time_left();
+	k_timer_tick();
+	k_crit_exit(basepri);
+	host_watch();
+	host_ipsr = 0;
+
+	// Still blocked by the kernel until the handler returns
+	host_pendsv();
+}
+
+/********************
+ * 					*
+ * INTRINSICS		*
+ * 					*
+ ********************/
+
+static uint64_t host_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+DWT_Type* host_dwt(void)
+{
+	static uint32_t base, last;
+	sigset_t saved;
+
+	// SysTick reads the counter too. Landing between the check and the stores below it
+	// would leave CYCCNT and last unequal, which reads as a write and rebases the count.
+	sigprocmask(SIG_BLOCK, &tick_set, &saved);
+	uint32_t now = (uint32_t)(host_ns() * (SystemCoreClock / 1000000) / 1000);
+
+	// A value other than the last one handed out was written through the previous pointer
+	if (host_dwt_regs.CYCCNT != last) base = now - host_dwt_regs.CYCCNT;
+	host_dwt_regs.CYCCNT = last = now - base;
+	sigprocmask(SIG_SETMASK, &saved, NULL);
+	return &host_dwt_regs;
+}
+
+SysTick_Type* host_systick(void)
+{
+	uint64_t cycles = (host_ns() - tick_ns) * (SystemCoreClock / 1000000) / 1000;
+	uint32_t load = host_systick_regs.LOAD;
+	host_systick_regs.VAL = (cycles < load) ? load - (uint32_t)cycles : 0;
+	return &host_systick_regs;
+}
+
+void __disable_irq(void)
+{
+	host_irq_block();
+	host_primask = 1;
+}
+
+void __enable_irq(void)
+{
+	host_primask = 0;
+	host_tail();
+}
+
+uint32_t __get_PRIMASK(void)
+{
+	return host_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+	if (primask) {
+		__disable_irq();
+	} else {
+		__enable_irq();
+	}
+}
+
+uint32_t __get_BASEPRI(void)
+{
+	return host_basepri;
+}
+
+void __set_BASEPRI(uint32_t basepri)
+{
+	if (basepri) {
+		host_irq_block();
+		host_basepri = basepri;
+	} else {
+		host_basepri = 0;
+		host_tail();
+	}
+}
+
+void __set_BASEPRI_MAX(uint32_t basepri)
+{
+	if (basepri && (host_basepri == 0 || basepri < host_basepri)) {
+		host_irq_block();
+		host_basepri = basepri;
+	}
+}
+
+uint32_t __get_IPSR(void)
+{
+	return host_ipsr;
+}
+
+void __set_PSP(uint32_t psp)
+{
+	(void)psp;
+}
+
+// Tasks run on host stacks: the last frame address stands in for the kernel's stack pointer
+uint32_t __get_PSP(void)
+{
+	return current_task ? current_task->stack_high : 0;
+}
+
+// STREX fails if the word changed or an exception ran since LDREX. The compare and
+// store is one instruction, so the SysTick signal can't split it.
+uint32_t __LDREXW(volatile uint32_t* addr)
+{
+	excl_value = *addr;
+	excl_addr = addr;
+	return excl_value;
+}
+
+uint32_t __STREXW(uint32_t value, volatile uint32_t* addr)
+{
+	uint32_t expected = excl_value;
+	if (excl_addr != addr) {
+		return 1;
+	}
+	excl_addr = NULL;
+	return !__atomic_compare_exchange_n(addr, &expected, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+void __CLREX(void)
+{
+	excl_addr = NULL;
+}
+
+// WFI: sleep until the next tick, unless a task became ready meanwhile
+void host_wfi(void)
+{
+	sigset_t none;
+	sigemptyset(&none);
+	host_irq_block();
+	if (prio_q_size == 0 && !(host_scb.ICSR & SCB_ICSR_PENDSVSET_Msk)) {
+		sigsuspend(&none);
+	}
+	host_irq_update();
+}
+
+void k_idle(void)
+{
+	__WFI();
+}
+
+/********************
+ * 					*
+ * HAL				*
+ * 					*
+ ********************/
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+	return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+	uwTick++;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return uwTick;
+}
+
+void HAL_Delay(uint32_t delay)
+{
+	uint32_t start = uwTick;
+	while (uwTick - start < delay);
+}
+
+void HAL_SuspendTick(void)
+{
+	tick_suspended = 1;
+}
+
+void HAL_ResumeTick(void)
+{
+	tick_suspended = 0;
+}
+
+void SystemClock_Config(void) {}
+void MX_GPIO_Init(void) {}
+void MX_USART2_UART_Init(void) {}
+
+void Error_Handler(void)
+{
+	fprintf(stderr, "host: Error_Handler\n");
+	abort();
+}
+
+/*
+ * stdio is not reentrant across task switches. The Makefile links with
+ * --wrap so printf, puts and putchar run as a kernel critical section, which
+ * is what log_write does on the target. Lines starting with PASS or FAIL are
+ * counted for the exit status.
+ */
+static void host_verdict(const char* line)
+{
+	if (strncmp(line, "PASS", 4) == 0) {
+		verdict_pass++;
+	} else if (strncmp(line, "FAIL", 4) == 0) {
+		verdict_fail++;
+	}
+}
+
+int __wrap_printf(const char* fmt, ...)
+{
+	char buf[256];
+	va_list ap, aq;
+	va_start(ap, fmt);
+	va_copy(aq, ap);
+
+	uint32_t basepri = k_crit_enter();
+	int len = vsnprintf(buf, sizeof(buf), fmt, aq);
+	if (len >= 0 && (size_t)len < sizeof(buf)) {
+		fputs(buf, stdout);
+	} else {
+		vfprintf(stdout, fmt, ap);
+	}
+	host_verdict(buf);
+	k_crit_exit(basepri);
+
+	va_end(aq);
+	va_end(ap);
+	return len;
+}
+
+int __wrap_puts(const char* s)
+{
+	uint32_t basepri = k_crit_enter();
+	host_verdict(s);
+	fputs(s, stdout);
+	int ret = fputc('\n', stdout);
+	k_crit_exit(basepri);
+	return ret;
+}
+
+int __wrap_putchar(int c)
+{
+	uint32_t basepri = k_crit_enter();
+	int ret = fputc(c, stdout);
+	k_crit_exit(basepri);
+	return ret;
+}
+
+/********************
+ * 					*
+ * STARTUP			*
+ * 					*
+ ********************/
+
+static void host_app_entry(void)
+{
+	host_app_main();
+	host_finish();
+}
+
+int main(void)
+{
+	extern uint32_t _estack;
+	if ((uintptr_t)&_estack > UINT32_MAX || (uintptr_t)&host_app_main > UINT32_MAX) {
+		fprintf(stderr, "host: image above 4 GiB, link with -no-pie\n");
+		return 2;
+	}
+
+	const char* env = getenv("HOST_TIMEOUT_MS");
+	if (env) timeout_ms = strtoul(env, NULL, 0);
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	for (int i = 0; i <= SVC_COUNT; i++) {
+		svc_insn[i][0] = i;
+		svc_insn[i][1] = 0xDF; // Thumb SVC encoding, 0xDFnn
+	}
+
+	// SysTick: 1 ms, with itself blocked while the handler runs
+	sigemptyset(&tick_set);
+	sigaddset(&tick_set, SIGALRM);
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = systick_handler;
+	sa.sa_mask = tick_set;
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &sa, NULL);
+
+	struct itimerval period = { { 0, 1000 }, { 0, 1000 } };
+	host_systick_regs.LOAD = SystemCoreClock / 1000 - 1;
+	host_systick_regs.CTRL = 0x7; // ENABLE | TICKINT | CLKSOURCE
+	tick_ns = host_ns();
+	setitimer(ITIMER_REAL, &period, NULL);
+
+	// main() of the test runs on a .bss stack too: it passes TCBs on its stack to the kernel
+	getcontext(&main_ctx);
+	main_ctx.uc_stack.ss_sp = main_stack;
+	main_ctx.uc_stack.ss_size = sizeof(main_stack);
+	main_ctx.uc_link = &boot_ctx;
+	sigemptyset(&main_ctx.uc_sigmask);
+	makecontext(&main_ctx, host_app_entry, 0);
+	swapcontext(&boot_ctx, &main_ctx);
+	return 0;
+}
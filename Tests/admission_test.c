@@ -0,0 +1,135 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+
+/*
+ * Admission control of tasks with a budget (ADMIT_BOUND_PERCENT at 100).
+ *
+ * The Checker, with the earliest deadline so the others stay READY, creates
+ * periodic tasks until their densities (budget / deadline) fill the CPU and
+ * checks that one more is refused while tasks without a budget still get in.
+ * It then moves a task's deadline: shortening it past what the bound allows
+ * must fail and leave the task as it was, lengthening it frees density. At
+ * the end every task exits, which must return the total to zero. Deadline and
+ * static tasks with a budget then fill the bound the same way.
+ *
+ * Densities are binary fractions so the rounded-up percentages are exact.
+ */
+
+#define CHECKER_DEADLINE 5
+
+K_TASK_STACK(static_stack, 0x400);
+K_TASK_STACK(spare_stack, 0x400);
+volatile int stop = 0;
+int failures = 0;
+
+static void expect(int ok, const char* what)
+{
+	if (!ok) {
+		printf("FAIL: %s\r\n", what);
+		failures++;
+	}
+}
+
+void Periodic(void *)
+{
+	while (!stop) osWaitNextPeriod();
+	osTaskExit();
+}
+
+void Worker(void *)
+{
+	osTaskExit();
+}
+
+static task_t create(int period, int deadline, int budget)
+{
+	TCB task;
+	task.stack_size = 0x400;
+	task.ptask = &Periodic;
+	if (osCreatePeriodicTask(period, deadline, budget, 0, &task) != RTX_OK) return TID_INVALID;
+	return task.tid;
+}
+
+void Checker(void *)
+{
+	TCB info;
+	expect(osGetUtilization() == 0, "utilization before any task");
+	expect(create(160, 160, 200) == TID_INVALID, "budget larger than the deadline accepted");
+
+	expect(create(160, 160, 80) != TID_INVALID, "50% refused");
+	expect(create(80, 80, 20) != TID_INVALID, "25% refused");
+	expect(create(80, 80, 40) == TID_INVALID, "50% more accepted");
+	expect(osGetUtilization() == 75, "refused task was counted");
+
+	// Density counts against the deadline, not the period
+	task_t d = create(320, 160, 20);
+	expect(d != TID_INVALID, "12.5% refused");
+	expect(create(160, 160, 20) != TID_INVALID, "12.5% up to the bound refused");
+	expect(osGetUtilization() == 100, "full utilization");
+	expect(create(1000, 1000, 1) == TID_INVALID, "task past the bound accepted");
+
+	TCB task;
+	task.stack_size = 0x400;
+	task.ptask = &Worker;
+	expect(osCreateDeadlineTask(200, &task) == RTX_OK, "task without a budget refused");
+
+	expect(osSetDeadline(80, d) == RTX_ERR, "deadline change past the bound accepted");
+	expect(osSetDeadline(0, d) == RTX_ERR, "zero deadline accepted for a task with a budget");
+	osTaskInfo(d, &info);
+	expect(info.deadline == 160, "refused deadline change was applied");
+	expect(osSetDeadline(320, d) == RTX_OK, "longer deadline refused");
+	expect(osGetUtilization() == 94, "longer deadline did not free density");
+	expect(osSetDeadline(640, d) == RTX_OK, "deadline past the period refused");
+	expect(osGetUtilization() == 94, "deadline past the period not bounded by the period");
+	expect(create(160, 160, 10) != TID_INVALID, "freed density not reusable");
+	expect(osGetUtilization() == 100, "utilization after reuse");
+
+	// Each task sees stop at its next release and exits
+	stop = 1;
+	osSleep(700);
+	expect(osGetUtilization() == 0, "exited tasks still hold density");
+	printf("utilization after exit: %d%%\r\n", osGetUtilization());
+
+	// Deadline tasks with a budget go through the same bound
+	expect(osCreateDeadlineTaskBudget(160, 200, &task) == RTX_ERR, "deadline task budget larger than the deadline accepted");
+	expect(osCreateDeadlineTaskBudget(160, 80, &task) == RTX_OK, "50% deadline task refused");
+	expect(osCreateTaskStatic(&task, static_stack, sizeof(static_stack), 80, 20) == RTX_OK, "25% static task refused");
+	expect(osCreateDeadlineTaskBudget(80, 40, &task) == RTX_ERR, "deadline task past the bound accepted");
+	expect(osCreateTaskStatic(&task, spare_stack, sizeof(spare_stack), 80, 40) == RTX_ERR, "static task past the bound accepted");
+	expect(osCreateDeadlineTaskBudget(80, 20, &task) == RTX_OK, "25% deadline task up to the bound refused");
+	expect(osGetUtilization() == 100, "budgeted deadline tasks not counted");
+	expect(osCreateDeadlineTask(200, &task) == RTX_OK, "deadline task without a budget refused");
+	osSleep(10); // The Workers exit
+	expect(osGetUtilization() == 0, "exited deadline tasks still hold density");
+
+	printf("%s\r\n", failures == 0 ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB task;
+  task.stack_size = 0x400;
+  task.ptask = &Checker;
+  osCreateDeadlineTask(CHECKER_DEADLINE, &task);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,120 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+
+/*
+ * Interrupt latency above the kernel ceiling.
+ *
+ * TIM2 runs at the core clock (84 MHz: APB1 / 2, timer clock x2) and
+ * overflows every 100 us. Its ISR, at NVIC priority 0, reads TIM2->CNT on
+ * entry: the count since the update event is the latency in cycles.
+ *
+ * Phase 1 keeps the kernel busy (osSetDeadline, CPU accounting, semaphore
+ * handoff, printf into the log ring, yields); none of it may delay TIM2.
+ * Phase 2 does the same kind of work inside __disable_irq() for comparison.
+ */
+
+#define TIM2_PRIORITY 0
+#define PERIOD_CYCLES 8400
+#define PHASE_MS 500
+
+volatile uint32_t lat_max = 0, lat_count = 0;
+k_sem_t ping;
+volatile int phase = 1;
+task_t partner_tid;
+
+void TIM2_IRQHandler(void)
+{
+	uint32_t latency = TIM2->CNT;
+	TIM2->SR = ~TIM_SR_UIF;
+	if (latency > lat_max) lat_max = latency;
+	lat_count++;
+}
+
+static void tim2_start(void)
+{
+	__HAL_RCC_TIM2_CLK_ENABLE();
+	TIM2->PSC = 0;
+	TIM2->ARR = PERIOD_CYCLES - 1;
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->SR = 0;
+	TIM2->DIER = TIM_DIER_UIE;
+	NVIC_SetPriority(TIM2_IRQn, TIM2_PRIORITY);
+	NVIC_EnableIRQ(TIM2_IRQn);
+	TIM2->CR1 = TIM_CR1_CEN;
+}
+
+void Partner(void *) {
+	while (1) {
+		osSemaphoreTake(&ping, OS_WAIT_FOREVER);
+		osYield();
+	}
+}
+
+void Stress(void *) {
+	uint64_t cycles;
+	int deadline = 20;
+
+	tim2_start();
+	uint32_t end = HAL_GetTick() + PHASE_MS;
+	while (HAL_GetTick() < end) {
+		osSetDeadline(deadline, partner_tid);
+		deadline = (deadline == 20) ? 30 : 20;
+		osTaskCpuCycles(osGetTID(), &cycles);
+		osGetCpuLoad();
+		osSemaphoreGive(&ping);
+		printf("x");
+	}
+	uint32_t kernel_max = lat_max;
+	uint32_t kernel_count = lat_count;
+	printf("\r\n");
+
+	lat_max = 0;
+	end = HAL_GetTick() + PHASE_MS;
+	while (HAL_GetTick() < end) {
+		__disable_irq();
+		osTaskCpuCycles(osGetTID(), &cycles);
+		osGetCpuLoad();
+		for (volatile int i = 0; i < 50; i++);
+		__enable_irq();
+	}
+	uint32_t primask_max = lat_max;
+
+	printf("TIM2 latency with kernel load: max %lu cycles over %lu interrupts\r\n", kernel_max, kernel_count);
+	printf("TIM2 latency with PRIMASK sections: max %lu cycles\r\n", primask_max);
+	printf("%s\r\n", kernel_max < primask_max ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+  osSemaphoreInit(&ping, 0);
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Partner;
+  osCreateDeadlineTask(20, &st_mytask);
+  partner_tid = st_mytask.tid;
+
+  st_mytask.ptask = &Stress;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
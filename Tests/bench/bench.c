@@ -0,0 +1,90 @@
+#include "main.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+
+uint32_t bench_overhead = 0;
+static uint8_t use_dwt = 1;
+
+static uint32_t systick_now(void)
+{
+	// Re-read until no tick happened in between
+	uint32_t tick, val;
+	do {
+		tick = HAL_GetTick();
+		val = SysTick->VAL;
+	} while (tick != HAL_GetTick());
+	uint32_t load = SysTick->LOAD + 1;
+	return tick * load + (load - 1 - val);
+}
+
+uint32_t bench_now(void)
+{
+	return use_dwt ? DWT->CYCCNT : systick_now();
+}
+
+void bench_init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	uint32_t start = DWT->CYCCNT;
+	for (volatile int i = 0; i < 100; i++);
+	use_dwt = (DWT->CYCCNT != start);
+
+	uint32_t min = UINT32_MAX;
+	for (int i = 0; i < 16; i++) {
+		uint32_t t = bench_now();
+		uint32_t d = bench_now() - t;
+		if (d < min) min = d;
+	}
+	bench_overhead = min;
+
+	printf("# clock_hz=%lu timer=%s overhead=%lu\r\n", (unsigned long)SystemCoreClock,
+			use_dwt ? "dwt" : "systick", (unsigned long)bench_overhead);
+	printf("bench,unit,n,min,median,p99,max\r\n");
+}
+
+void bench_begin(bench_t* b, const char* name, const char* unit)
+{
+	b->name = name;
+	b->unit = unit;
+	b->warmup = BENCH_WARMUP;
+	b->n = 0;
+}
+
+int bench_add(bench_t* b, uint32_t value)
+{
+	if (b->warmup > 0) {
+		b->warmup--;
+	} else if (b->n < BENCH_MAX_SAMPLES) {
+		b->samples[b->n++] = value;
+	}
+	return b->n >= BENCH_MAX_SAMPLES;
+}
+
+int bench_add_timed(bench_t* b, uint32_t start)
+{
+	uint32_t d = bench_now() - start;
+	return bench_add(b, d > bench_overhead ? d - bench_overhead : 0);
+}
+
+static int cmp_u32(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+void bench_report(bench_t* b)
+{
+	if (b->n == 0) {
+		printf("# %s: no samples\r\n", b->name);
+		return;
+	}
+
+	qsort(b->samples, b->n, sizeof(uint32_t), cmp_u32);
+	uint32_t p99 = b->samples[(b->n * 99 + 99) / 100 - 1];
+	printf("%s,%s,%lu,%lu,%lu,%lu,%lu\r\n", b->name, b->unit, (unsigned long)b->n,
+			(unsigned long)b->samples[0], (unsigned long)b->samples[b->n / 2],
+			(unsigned long)p99, (unsigned long)b->samples[b->n - 1]);
+}
@@ -0,0 +1,69 @@
+/*
+ * bench.h
+ *
+ *      Shared measurement helpers for the benchmarks in Tests/bench.
+ *
+ *      Timestamps come from DWT->CYCCNT. Where the cycle counter does not run
+ *      (QEMU does not model the DWT) bench_init falls back to HAL_GetTick and
+ *      SysTick->VAL, which is also in core clock cycles. Each benchmark collects
+ *      up to BENCH_MAX_SAMPLES samples after discarding its warmup samples, and
+ *      bench_report prints one CSV row:
+ *
+ *          bench,unit,n,min,median,p99,max
+ *
+ *      Lines starting with '#' are comments, so a capture of the UART can be
+ *      fed to Tools/bench_compare.py as is.
+ */
+#include <stdint.h>
+
+#ifndef TESTS_BENCH_BENCH_H_
+#define TESTS_BENCH_BENCH_H_
+
+#define BENCH_MAX_SAMPLES 256
+#define BENCH_WARMUP 8
+
+typedef struct {
+    const char* name;
+    const char* unit;
+    uint32_t warmup;                        // Samples still to discard
+    uint32_t n;                             // Samples kept
+    uint32_t samples[BENCH_MAX_SAMPLES];
+} bench_t;
+
+extern uint32_t bench_overhead;             // Cycles of an empty bench_now() pair, subtracted by bench_add_timed
+
+/**
+ * @brief Pick the time source, measure bench_overhead and print the CSV header
+ */
+void bench_init(void);
+
+/**
+ * @brief Current time in core clock cycles (wraps at 32 bits)
+ */
+uint32_t bench_now(void);
+
+/**
+ * @brief Start a benchmark
+ * @param b Sample storage
+ * @param name Column "bench" of the CSV row
+ * @param unit Column "unit", usually "cycles"
+ */
+void bench_begin(bench_t* b, const char* name, const char* unit);
+
+/**
+ * @brief Record one sample, or drop it while still warming up
+ * @return int 1 once BENCH_MAX_SAMPLES samples are kept, 0 otherwise
+ */
+int bench_add(bench_t* b, uint32_t value);
+
+/**
+ * @brief Record the time since start, less bench_overhead
+ */
+int bench_add_timed(bench_t* b, uint32_t start);
+
+/**
+ * @brief Sort the samples and print the CSV row
+ */
+void bench_report(bench_t* b);
+
+#endif /* TESTS_BENCH_BENCH_H_ */
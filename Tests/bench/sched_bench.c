@@ -0,0 +1,309 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+#include "k_sync.h"
+#include "bench.h"
+
+/*
+ * Scheduler and allocator benchmarks, printed as CSV (see bench.h).
+ *
+ * The Runner task (deadline RUNNER_DEADLINE) runs each benchmark in turn:
+ *
+ *   yield_noswitch         osYield with no other task ready (PendSV fast path)
+ *   sem_switch             osSemaphoreGive until the earlier-deadline task blocked on
+ *                          the semaphore runs (osYield only switches once a tick has
+ *                          made the other task's deadline earlier)
+ *   systick_preempt        SysTick to first instruction of a task woken by it,
+ *                          while the Runner spins (read from SysTick->VAL)
+ *   create_to_run          osCreateDeadlineTask until the new, earlier task runs
+ *   exit_to_resume         osTaskExit until the Runner runs again
+ *   sleep_1ms/sleep_10ms   osSleep duration, started right after a tick
+ *   set_deadline           osSetDeadline on a READY task that does not preempt
+ *   alloc_free_32          k_mem_alloc + k_mem_dealloc of 32 bytes, empty heap
+ *   alloc_fragmented       k_mem_alloc of 128 bytes past 32 free 64-byte holes
+ *   free_coalesce          k_mem_dealloc of a block between two free blocks
+ *
+ * Build for the board like any other test, or under QEMU with LOG_ASYNC 0
+ * (no DMA there); on Linux: make -C Host bench.
+ */
+
+#define RUNNER_DEADLINE 50
+#define ITERS (BENCH_WARMUP + BENCH_MAX_SAMPLES)
+#define SLEEP_ITERS (BENCH_WARMUP + 32)
+#define FRAG_BLOCKS 64
+
+bench_t b1, b2;
+k_sem_t sem;
+volatile uint32_t t_stamp;
+volatile int stop = 0;
+volatile int preempt_done = 0;
+int failures = 0;
+
+/********************
+ * 					*
+ * YIELD			*
+ * 					*
+ ********************/
+
+static void bench_yield_noswitch(void)
+{
+	bench_begin(&b1, "yield_noswitch", "cycles");
+	for (int i = 0; i < ITERS; i++) {
+		uint32_t start = bench_now();
+		osYield();
+		bench_add_timed(&b1, start);
+	}
+	bench_report(&b1);
+}
+
+void Taker(void *)
+{
+	while (1) {
+		osSemaphoreTake(&sem, OS_WAIT_FOREVER);
+		if (stop) osTaskExit();
+		bench_add_timed(&b1, t_stamp);
+	}
+}
+
+static void bench_sem_switch(void)
+{
+	TCB task;
+	task.stack_size = 0x400;
+	task.ptask = &Taker;
+	stop = 0;
+	osSemaphoreInit(&sem, 0);
+	if (osCreateDeadlineTask(RUNNER_DEADLINE / 2, &task) != RTX_OK) {
+		failures++;
+		return;
+	}
+
+	bench_begin(&b1, "sem_switch", "cycles");
+	for (int i = 0; i < ITERS; i++) {
+		t_stamp = bench_now();
+		osSemaphoreGive(&sem);
+	}
+	stop = 1;
+	osSemaphoreGive(&sem);
+	bench_report(&b1);
+}
+
+/********************
+ * 					*
+ * PREEMPTION		*
+ * 					*
+ ********************/
+
+void Waker(void *)
+{
+	osSleep(1);
+	for (int i = 0; i < ITERS; i++) {
+		osSleep(1);
+		// SysTick counts down from LOAD and fired when it reloaded
+		bench_add(&b1, SysTick->LOAD - SysTick->VAL);
+	}
+	preempt_done = 1;
+	osTaskExit();
+}
+
+static void bench_systick_preempt(void)
+{
+	TCB task;
+	task.stack_size = 0x400;
+	task.ptask = &Waker;
+	preempt_done = 0;
+	bench_begin(&b1, "systick_preempt", "cycles");
+	if (osCreateDeadlineTask(2, &task) != RTX_OK) {
+		failures++;
+		return;
+	}
+
+	while (!preempt_done);
+	bench_report(&b1);
+}
+
+/********************
+ * 					*
+ * CREATE/EXIT		*
+ * 					*
+ ********************/
+
+void Churn(void *)
+{
+	bench_add_timed(&b1, t_stamp);
+	t_stamp = bench_now();
+	osTaskExit();
+}
+
+static void bench_create_exit(void)
+{
+	TCB task;
+	task.stack_size = 0x400;
+	task.ptask = &Churn;
+	bench_begin(&b1, "create_to_run", "cycles");
+	bench_begin(&b2, "exit_to_resume", "cycles");
+
+	for (int i = 0; i < ITERS; i++) {
+		t_stamp = bench_now();
+		if (osCreateDeadlineTask(1, &task) != RTX_OK) {
+			failures++;
+			return;
+		}
+		bench_add_timed(&b2, t_stamp);
+	}
+	bench_report(&b1);
+	bench_report(&b2);
+}
+
+/********************
+ * 					*
+ * SLEEP			*
+ * 					*
+ ********************/
+
+static void bench_sleep(const char* name, int ms)
+{
+	bench_begin(&b1, name, "cycles");
+	for (int i = 0; i < SLEEP_ITERS; i++) {
+		osSleep(1); // Start right after a tick
+		uint32_t start = bench_now();
+		osSleep(ms);
+		bench_add_timed(&b1, start);
+	}
+	bench_report(&b1);
+}
+
+/********************
+ * 					*
+ * DEADLINE			*
+ * 					*
+ ********************/
+
+void Bystander(void *)
+{
+	osTaskExit();
+}
+
+static void bench_set_deadline(void)
+{
+	TCB task;
+	task.stack_size = 0x400;
+	task.ptask = &Bystander;
+	if (osCreateDeadlineTask(10 * RUNNER_DEADLINE, &task) != RTX_OK) {
+		failures++;
+		return;
+	}
+
+	bench_begin(&b1, "set_deadline", "cycles");
+	for (int i = 0; i < ITERS; i++) {
+		int deadline = (i & 1) ? 10 * RUNNER_DEADLINE : 20 * RUNNER_DEADLINE;
+		uint32_t start = bench_now();
+		if (osSetDeadline(deadline, task.tid) != RTX_OK) failures++;
+		bench_add_timed(&b1, start);
+	}
+	bench_report(&b1);
+	osSleep(1); // Let the bystander run and exit
+}
+
+/********************
+ * 					*
+ * ALLOCATOR		*
+ * 					*
+ ********************/
+
+static void bench_alloc(void)
+{
+	bench_begin(&b1, "alloc_free_32", "cycles");
+	for (int i = 0; i < ITERS; i++) {
+		uint32_t start = bench_now();
+		void* p = k_mem_alloc(32);
+		k_mem_dealloc(p);
+		bench_add_timed(&b1, start);
+		if (p == NULL) failures++;
+	}
+	bench_report(&b1);
+
+	// Every other block freed: first fit walks past FRAG_BLOCKS / 2 holes
+	void* blocks[FRAG_BLOCKS];
+	for (int i = 0; i < FRAG_BLOCKS; i++) {
+		blocks[i] = k_mem_alloc(64);
+		if (blocks[i] == NULL) failures++;
+	}
+	for (int i = 0; i < FRAG_BLOCKS; i += 2) {
+		k_mem_dealloc(blocks[i]);
+	}
+
+	bench_begin(&b1, "alloc_fragmented", "cycles");
+	for (int i = 0; i < ITERS; i++) {
+		uint32_t start = bench_now();
+		void* p = k_mem_alloc(128);
+		bench_add_timed(&b1, start);
+		k_mem_dealloc(p);
+	}
+	bench_report(&b1);
+
+	for (int i = 1; i < FRAG_BLOCKS; i += 2) {
+		k_mem_dealloc(blocks[i]);
+	}
+
+	// B is freed between free A and C; D keeps C from merging with the rest of the heap
+	bench_begin(&b1, "free_coalesce", "cycles");
+	for (int i = 0; i < ITERS; i++) {
+		void* a = k_mem_alloc(64);
+		void* b = k_mem_alloc(64);
+		void* c = k_mem_alloc(64);
+		void* d = k_mem_alloc(64);
+		k_mem_dealloc(a);
+		k_mem_dealloc(c);
+		uint32_t start = bench_now();
+		if (k_mem_dealloc(b) != RTX_OK) failures++;
+		bench_add_timed(&b1, start);
+		k_mem_dealloc(d);
+	}
+	bench_report(&b1);
+}
+
+void Runner(void *)
+{
+	bench_init();
+
+	bench_yield_noswitch();
+	bench_sem_switch();
+	bench_systick_preempt();
+	bench_create_exit();
+	bench_sleep("sleep_1ms", 1);
+	bench_sleep("sleep_10ms", 10);
+	bench_set_deadline();
+	bench_alloc();
+
+	printf("# %d failed calls\r\n", failures);
+	printf("%s\r\n", failures == 0 ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Runner;
+  osCreateDeadlineTask(RUNNER_DEADLINE, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,104 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+
+#define  ARM_CM_DEMCR      (*(uint32_t *)0xE000EDFC)
+#define  ARM_CM_DWT_CTRL   (*(uint32_t *)0xE0001000)
+#define  ARM_CM_DWT_CYCCNT (*(uint32_t *)0xE0001004)
+
+/*
+ * Cycle cost of osYield -> SVC -> PendSV -> resume.
+ *
+ * Phase 1 (no switch): TaskA is the only ready task, so every yield re-selects
+ * it and PendSV takes the fast path.
+ * Phase 2 (switch): TaskA and TaskB have equal deadlines and yield to each
+ * other. TaskA stamps the cycle counter right before osYield and TaskB reads
+ * it right after its own osYield returns.
+ *
+ * Build with STACK_GUARD set to 0 and 1 to see the PendSV cost of
+ * reprogramming the MPU guard region on every switch.
+ */
+
+#define N 100
+
+volatile uint32_t t_yield;
+uint32_t samples[N];
+int n_samples = 0;
+
+static void report(const char *name)
+{
+	uint32_t min = 0xFFFFFFFF, max = 0, sum = 0;
+	for (int i = 0; i < N; i++) {
+		if (samples[i] < min) min = samples[i];
+		if (samples[i] > max) max = samples[i];
+		sum += samples[i];
+	}
+	printf("%s: min %lu, avg %lu, max %lu cycles\r\n", name, min, sum / N, max);
+}
+
+void TaskB(void *) {
+	while (1) {
+		osYield();
+		if (n_samples < N) {
+			samples[n_samples++] = ARM_CM_DWT_CYCCNT - t_yield;
+		}
+	}
+}
+
+void TaskA(void *) {
+	for (int i = 0; i < N; i++) {
+		uint32_t start = ARM_CM_DWT_CYCCNT;
+		osYield();
+		samples[i] = ARM_CM_DWT_CYCCNT - start;
+	}
+	report("osYield, no switch");
+
+	n_samples = 0;
+	TCB st_mytask;
+	st_mytask.stack_size = 0x400;
+	st_mytask.ptask = &TaskB;
+	osCreateTask(&st_mytask);
+
+	while (n_samples < N) {
+		t_yield = ARM_CM_DWT_CYCCNT;
+		osYield();
+	}
+	report("osYield, switch to other task");
+
+	printf("back to main\r\n");
+	while (1);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  ARM_CM_DEMCR      |= 1 << 24;  // Set bit 24
+  ARM_CM_DWT_CYCCNT  = 0;
+  ARM_CM_DWT_CTRL   |= 1 << 0;   // Set bit 0
+
+  printf("stack guard: %s\r\n", STACK_GUARD ? "on" : "off");
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &TaskA;
+  osCreateTask(&st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,112 @@
+#include "main.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+
+/*
+ * Checks the per-task cycle accounting against known busy-loop workloads.
+ *
+ * TaskA and TaskB each burn a fixed number of cycles per period (measured
+ * locally with DWT->CYCCNT) and then sleep. The bursts are short compared to
+ * a tick, so they are rarely preempted and the kernel's count for each task
+ * should match the locally measured busy time to within a few percent (the
+ * difference is SysTick and syscall overhead charged to the running task).
+ * The reporter then compares idle time against osGetCpuLoad.
+ */
+
+#define BURST_A 20000   // cycles per period, ~0.24 ms at 84 MHz
+#define BURST_B 60000   // cycles per period, ~0.71 ms at 84 MHz
+#define PERIODS 200
+
+volatile uint64_t busy_a = 0;
+volatile uint64_t busy_b = 0;
+volatile int done = 0;
+
+static uint32_t burn(uint32_t cycles)
+{
+	uint32_t start = DWT->CYCCNT;
+	while (DWT->CYCCNT - start < cycles);
+	return DWT->CYCCNT - start;
+}
+
+void TaskA(void *) {
+	for (int i = 0; i < PERIODS; i++) {
+		busy_a += burn(BURST_A);
+		osSleep(2);
+	}
+	done++;
+	while (1) osSleep(1000);
+}
+
+void TaskB(void *) {
+	for (int i = 0; i < PERIODS; i++) {
+		busy_b += burn(BURST_B);
+		osSleep(2);
+	}
+	done++;
+	while (1) osSleep(1000);
+}
+
+static int check(const char *name, uint64_t kernel, uint64_t expected)
+{
+	// Kernel count may only be higher, by interrupt and syscall overhead
+	uint64_t diff = (kernel > expected) ? kernel - expected : expected - kernel;
+	int ok = (kernel >= expected) && (diff * 100 <= expected * 5);
+	printf("%s: %s kernel %" PRIu32 " cycles, busy loop %" PRIu32 " cycles\r\n", ok ? "PASS" : "FAIL",
+			name, (uint32_t)kernel, (uint32_t)expected);
+	return ok;
+}
+
+void Reporter(void *) {
+	osGetCpuLoad(); // start a fresh load window
+	while (done < 2) osSleep(10);
+
+	int load = osGetCpuLoad();
+	TCB info_a, info_b;
+	uint64_t idle;
+	osTaskInfo(1, &info_a);
+	osTaskInfo(2, &info_b);
+	osTaskCpuCycles(TID_NULL, &idle);
+
+	int ok = check("TaskA", info_a.cpu_cycles, busy_a);
+	ok &= check("TaskB", info_b.cpu_cycles, busy_b);
+
+	printf("null task %" PRIu32 " cycles, load over the run %d%%\r\n", (uint32_t)idle, load);
+	printf("%s\r\n", ok ? "PASS: accounting matches workload" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+
+  st_mytask.ptask = &TaskA;
+  osCreateDeadlineTask(2, &st_mytask);
+
+  st_mytask.ptask = &TaskB;
+  osCreateDeadlineTask(2, &st_mytask);
+
+  st_mytask.ptask = &Reporter;
+  osCreateDeadlineTask(50, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
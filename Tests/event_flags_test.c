@@ -0,0 +1,129 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+
+/*
+ * Event flag groups.
+ *
+ * Three waiters block on one group:
+ *  - AllWaiter waits for DATA and BUF (wait-all, auto-clear)
+ *  - AnyWaiter waits for DATA or ERROR (wait-any)
+ *  - TimeoutWaiter waits for ERROR with a 20ms timeout and should time out
+ * The controller sets DATA, which must release only AnyWaiter, then BUF from
+ * the B1 EXTI handler, which must release AllWaiter. Both waiters see DATA in
+ * the same pass even though AllWaiter auto-clears it.
+ */
+
+#define EV_DATA  0x1
+#define EV_BUF   0x2
+#define EV_ERROR 0x4
+
+k_event_t ev;
+volatile int all_woken = 0, any_woken = 0, timed_out = 0;
+volatile uint32_t all_flags, any_flags;
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	osEventSetFromISR(&ev, EV_BUF);
+}
+
+void AllWaiter(void *) {
+	uint32_t flags;
+	if (osEventWait(&ev, EV_DATA | EV_BUF, OS_EVENT_WAIT_ALL | OS_EVENT_AUTO_CLEAR, OS_WAIT_FOREVER, &flags) == RTX_OK) {
+		all_flags = flags;
+		all_woken = 1;
+	}
+	while (1) osSleep(1000);
+}
+
+void AnyWaiter(void *) {
+	uint32_t flags;
+	if (osEventWait(&ev, EV_DATA | EV_ERROR, OS_EVENT_WAIT_ANY, OS_WAIT_FOREVER, &flags) == RTX_OK) {
+		any_flags = flags;
+		any_woken = 1;
+	}
+	while (1) osSleep(1000);
+}
+
+void TimeoutWaiter(void *) {
+	if (osEventWait(&ev, EV_ERROR, OS_EVENT_WAIT_ANY, 20, NULL) == RTX_ERR) {
+		timed_out = 1;
+	}
+	while (1) osSleep(1000);
+}
+
+void Controller(void *) {
+	int pass = 1;
+	osSleep(5); // let every waiter block
+
+	osEventSet(&ev, EV_DATA);
+	osSleep(1);
+	if (!any_woken || all_woken || any_flags != EV_DATA) {
+		printf("set DATA: any %d all %d\r\n", any_woken, all_woken);
+		pass = 0;
+	}
+
+	EXTI->SWIER = B1_Pin;
+	osSleep(1);
+	if (!all_woken || all_flags != (EV_DATA | EV_BUF)) {
+		printf("set BUF from ISR: all %d flags %lx\r\n", all_woken, all_flags);
+		pass = 0;
+	}
+	if (ev.flags != 0) {
+		printf("auto-clear left %lx\r\n", ev.flags);
+		pass = 0;
+	}
+
+	osSleep(30);
+	if (!timed_out) {
+		printf("timeout waiter still blocked\r\n");
+		pass = 0;
+	}
+
+	// Non-blocking wait and clear
+	osEventSet(&ev, EV_ERROR);
+	if (osEventWait(&ev, EV_BUF, OS_EVENT_WAIT_ANY, 0, NULL) != RTX_ERR) pass = 0;
+	if (osEventClear(&ev, EV_ERROR) != EV_ERROR || ev.flags != 0) pass = 0;
+
+	printf("%s\r\n", pass ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+  osEventInit(&ev);
+
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, KERNEL_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+
+  st_mytask.ptask = &AllWaiter;
+  osCreateDeadlineTask(4, &st_mytask);
+  st_mytask.ptask = &AnyWaiter;
+  osCreateDeadlineTask(6, &st_mytask);
+  st_mytask.ptask = &TimeoutWaiter;
+  osCreateDeadlineTask(8, &st_mytask);
+  st_mytask.ptask = &Controller;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,120 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+
+#define  ARM_CM_DEMCR      (*(uint32_t *)0xE000EDFC)
+#define  ARM_CM_DWT_CTRL   (*(uint32_t *)0xE0001000)
+#define  ARM_CM_DWT_CYCCNT (*(uint32_t *)0xE0001004)
+
+/*
+ * Benchmark for a floating-point biquad filter running in two tasks that
+ * keep yielding to each other, so every sample crosses a context switch
+ * with a live FP context.
+ *
+ * Build once with Floating-point ABI = soft (-mfloat-abi=soft) and once with
+ * hard (-mfpu=fpv4-sp-d16 -mfloat-abi=hard) and compare the cycle counts.
+ * Both tasks filter the same input, so their outputs must match exactly;
+ * a mismatch means S16-S31 were not preserved across a switch.
+ */
+
+#define N_SAMPLES 256
+
+typedef struct {
+	float b0, b1, b2, a1, a2;
+	float x1, x2, y1, y2;
+} biquad_t;
+
+volatile float out_a[N_SAMPLES];
+volatile float out_b[N_SAMPLES];
+volatile uint32_t cycles_a = 0;
+volatile uint32_t cycles_b = 0;
+volatile int done = 0;
+
+static float biquad_step(biquad_t *f, float x)
+{
+	float y = f->b0 * x + f->b1 * f->x1 + f->b2 * f->x2 - f->a1 * f->y1 - f->a2 * f->y2;
+	f->x2 = f->x1;
+	f->x1 = x;
+	f->y2 = f->y1;
+	f->y1 = y;
+	return y;
+}
+
+static void run_filter(volatile float *out, volatile uint32_t *cycles)
+{
+	// 2nd order low-pass, fc = fs/10
+	biquad_t f = { 0.0675f, 0.1349f, 0.0675f, -1.1430f, 0.4128f, 0, 0, 0, 0 };
+	uint32_t total = 0;
+
+	for (int i = 0; i < N_SAMPLES; i++) {
+		float x = (i & 16) ? 1.0f : -1.0f; // square wave input
+		uint32_t start = ARM_CM_DWT_CYCCNT;
+		out[i] = biquad_step(&f, x);
+		total += ARM_CM_DWT_CYCCNT - start;
+		osYield(); // force a switch with the FP registers live
+	}
+	*cycles = total;
+}
+
+void TaskA(void *) {
+	run_filter(out_a, &cycles_a);
+	done++;
+	while (1) osYield();
+}
+
+void TaskB(void *) {
+	run_filter(out_b, &cycles_b);
+	done++;
+	while (done < 2) osYield();
+
+	int mismatches = 0;
+	for (int i = 0; i < N_SAMPLES; i++) {
+		if (out_a[i] != out_b[i]) mismatches++;
+	}
+	printf("filter cycles: task A %lu, task B %lu (%lu per sample)\r\n",
+			cycles_a, cycles_b, cycles_a / N_SAMPLES);
+	printf("%s: %d mismatched samples\r\n", mismatches ? "FAIL" : "PASS", mismatches);
+	while (1) osYield();
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  ARM_CM_DEMCR      |= 1 << 24;  // Set bit 24
+  ARM_CM_DWT_CYCCNT  = 0;
+  ARM_CM_DWT_CTRL   |= 1 << 0;   // Set bit 0
+
+#if (__FPU_USED == 1U)
+  printf("FPU: hard-float, lazy stacking\r\n");
+#else
+  printf("FPU: software emulation\r\n");
+#endif
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+
+  st_mytask.ptask = &TaskA;
+  osCreateTask(&st_mytask);
+
+  st_mytask.ptask = &TaskB;
+  osCreateTask(&st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
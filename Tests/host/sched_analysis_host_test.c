@@ -0,0 +1,101 @@
+/*
+ * Host-side test of the schedulability analysis in k_sched_analysis.c: known
+ * EDF task sets, feasible and not, through the utilization and processor-demand
+ * tests, plus the admission arithmetic the kernel uses.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -ICore/Inc Tests/host/sched_analysis_host_test.c Core/Src/k_sched_analysis.c -o sched_analysis_host_test
+ *   ./sched_analysis_host_test
+ * (make -C Host check also runs it.)
+ */
+#include <stdio.h>
+#include <stdint.h>
+
+#include "k_sched_analysis.h"
+
+#define N(set) ((int)(sizeof(set) / sizeof((set)[0])))
+
+static int failures = 0;
+
+static void expect(int cond, const char* what)
+{
+	if (!cond) {
+		printf("FAIL: %s\n", what);
+		failures++;
+	}
+}
+
+// Runs both tests on a set and checks the verdicts and the reported miss
+static void check_set(const char* name, const k_task_param_t* set, int n,
+		int util_expected, int demand_expected, uint32_t miss_expected)
+{
+	uint32_t miss_at = 0xFFFFFFFFU;
+	int util = k_sched_utilization_test(set, n);
+	int demand = k_sched_demand_test(set, n, &miss_at);
+
+	printf("%-28s utilization %s, demand %s", name,
+			util == RTX_OK ? "ok  " : "fail", demand == RTX_OK ? "ok" : "fail");
+	if (miss_at) printf(" (dbf(t) > t at t = %u)", miss_at);
+	printf("\n");
+
+	expect(util == util_expected, name);
+	expect(demand == demand_expected, name);
+	expect(miss_at == miss_expected, name);
+}
+
+int main(void)
+{
+	// Densities 2/3 + 1/2 > 1, yet every deadline is met
+	const k_task_param_t dense[] = { {2, 3, 6}, {2, 4, 8} };
+	check_set("dense but feasible", dense, N(dense), RTX_OK, RTX_OK, 0);
+
+	// Both jobs due at 2 need 3 ms
+	const k_task_param_t collide[] = { {2, 2, 5}, {1, 2, 5} };
+	check_set("simultaneous deadlines", collide, N(collide), RTX_OK, RTX_ERR, 2);
+
+	// Utilization 0.92, but dbf(3) = 1 + 2 + 1 = 4
+	const k_task_param_t tight[] = { {1, 1, 4}, {2, 3, 6}, {1, 2, 3} };
+	check_set("constrained miss", tight, N(tight), RTX_OK, RTX_ERR, 3);
+
+	// Utilization above 1 fails both tests, with no deadline to report
+	const k_task_param_t overload[] = { {3, 5, 5}, {3, 5, 5} };
+	check_set("overload", overload, N(overload), RTX_ERR, RTX_ERR, 0);
+
+	// Exactly 1 with implicit deadlines is schedulable under EDF
+	const k_task_param_t full[] = { {1, 2, 2}, {2, 4, 4} };
+	check_set("utilization 1", full, N(full), RTX_OK, RTX_OK, 0);
+
+	// 1/3 + 2/3 has no exact binary fraction
+	const k_task_param_t thirds[] = { {1, 3, 3}, {2, 3, 3} };
+	check_set("utilization 1 in thirds", thirds, N(thirds), RTX_OK, RTX_OK, 0);
+
+	// Coprime periods: a long busy period with many deadlines to visit
+	const k_task_param_t coprime[] = { {20, 90, 97}, {30, 95, 101}, {40, 100, 103}, {5, 40, 89} };
+	check_set("coprime periods", coprime, N(coprime), RTX_OK, RTX_OK, 0);
+
+	// Deadline after the period is outside the constrained model
+	const k_task_param_t late[] = { {1, 6, 5} };
+	check_set("deadline after period", late, N(late), RTX_OK, RTX_ERR, 0);
+
+	// Densities are Q16 and rounded up
+	expect(k_density(1, 2) == DENSITY_ONE / 2, "k_density(1, 2)");
+	expect(k_density(1, 3) == DENSITY_ONE / 3 + 1, "k_density rounds up");
+	expect(k_density(0, 0) == 0, "no budget, no density");
+	expect(k_density(1, 0) == UINT32_MAX, "zero deadline");
+
+	// Admission against ADMIT_BOUND_PERCENT (100)
+	k_admit_init();
+	expect(k_admit(0, DENSITY_ONE / 2) == RTX_OK, "admit 50%");
+	expect(k_admit(0, DENSITY_ONE / 4) == RTX_OK, "admit 25%");
+	expect(k_admit(0, DENSITY_ONE / 2) == RTX_ERR, "refuse 50% more");
+	expect(k_density_total() == DENSITY_ONE * 3 / 4, "refusal leaves the total");
+	expect(k_admit(0, DENSITY_ONE / 4) == RTX_OK, "admit up to the bound");
+	expect(k_admit(0, 1) == RTX_ERR, "refuse past the bound");
+	expect(k_admit(DENSITY_ONE / 4, DENSITY_ONE / 2) == RTX_ERR, "refuse a larger replacement");
+	expect(k_admit(DENSITY_ONE / 2, DENSITY_ONE / 4) == RTX_OK, "accept a smaller replacement");
+	expect(k_admit(DENSITY_ONE / 4, 0) == RTX_OK, "release");
+	expect(k_density_total() == DENSITY_ONE / 2, "total after release");
+
+	printf("%s\n", failures == 0 ? "PASS" : "FAIL");
+	return failures != 0;
+}
@@ -0,0 +1,84 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_idle.h"
+
+/*
+ * Idle power modes.
+ *
+ * With only this task in the system every osSleep leaves the CPU idle. For
+ * each mode the task sleeps repeatedly and measures the wake-up latency: the
+ * cycles from the core leaving WFI/STOP (idle_wake_stamp) until the task runs
+ * again. STOP also has to restore the PLL, so its latency is larger; its
+ * sleeps are long enough (IDLE_STOP_MIN_MS or more) to take the tickless path.
+ * The tick must not drift across STOP and the idle hook must run. Before the
+ * STOP rounds the null task measures the LSI, whose frequency is printed.
+ */
+
+#define ROUNDS 20
+
+volatile uint32_t hook_runs = 0;
+
+void CountHook(void) {
+	hook_runs++;
+}
+
+static uint32_t measure(int mode, uint32_t sleep_ms, uint32_t* drift) {
+	uint32_t max = 0;
+	osIdleSetMode(mode);
+	osSleep(mode == IDLE_STOP ? 200 : 1); // let printf drain, and the LSI be measured
+	uint32_t start = HAL_GetTick();
+	for (int i = 0; i < ROUNDS; i++) {
+		osSleep(sleep_ms);
+		uint32_t latency = DWT->CYCCNT - idle_wake_stamp;
+		if (latency > max) max = latency;
+	}
+	uint32_t elapsed = HAL_GetTick() - start;
+	*drift = elapsed > ROUNDS * sleep_ms ? elapsed - ROUNDS * sleep_ms : ROUNDS * sleep_ms - elapsed;
+	return max;
+}
+
+void Sleeper(void *) {
+	uint32_t wfi_drift, stop_drift;
+	osIdleHookAdd(&CountHook);
+
+	uint32_t wfi = measure(IDLE_WFI, 10, &wfi_drift);
+	uint32_t stop = measure(IDLE_STOP, 50, &stop_drift);
+	osIdleSetMode(IDLE_WFI);
+
+	printf("WFI: wake latency max %lu cycles, drift %lu ms\r\n", wfi, wfi_drift);
+	printf("STOP: wake latency max %lu cycles, drift %lu ms\r\n", stop, stop_drift);
+	printf("LSI measured at %lu Hz\r\n", idle_lsi_hz);
+	printf("idle hook runs: %lu, cpu load %d%%\r\n", hook_runs, osGetCpuLoad());
+
+	int pass = hook_runs > 0 && stop_drift <= ROUNDS && osIdleSetMode(7) == RTX_ERR;
+	printf("%s\r\n", pass ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Sleeper;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,156 @@
+#include "main.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+#include "k_sync.h"
+
+/*
+ * Run-to-completion jobs on the shared stack.
+ *
+ * FastJob (2 ms) and SlowJob (20 ms, busy for 3 ms) are jobs, Spinner is an
+ * ordinary task that is busy for 1 ms every 5 ms. FastJob keeps preempting
+ * SlowJob, so its frames nest above SlowJob's on the shared stack; SlowJob
+ * checks that a local array survived each of those preemptions. Over
+ * MEASURE_MS the Checker compares the number of releases with the periods,
+ * and that creating the jobs used no heap. A job's first release also checks
+ * that it cannot block or sleep.
+ */
+
+#define FAST_PERIOD 2
+#define SLOW_PERIOD 20
+#define SLOW_BUSY_MS 3
+#define MEASURE_MS 400
+#define LOCALS 32
+
+volatile int fast_runs = 0, slow_runs = 0;
+volatile int nested = 0;        // FastJob releases that ran while SlowJob was in progress
+volatile int slow_active = 0;
+volatile int corrupted = 0;
+volatile int block_failed = 0;  // Blocking calls from a job that failed as they should
+k_sem_t never;
+int failures = 0;
+
+static void burn_ms(uint32_t ms)
+{
+	uint32_t start = DWT->CYCCNT;
+	while (DWT->CYCCNT - start < ms * (SystemCoreClock / 1000));
+}
+
+// Allocates and frees a small block, returns where it landed
+static void* heap_probe(void)
+{
+	void* p = k_mem_alloc(8);
+	k_mem_dealloc(p);
+	return p;
+}
+
+void FastJob(void *)
+{
+	if (fast_runs == 0) {
+		uint32_t tick = HAL_GetTick();
+		osSleep(10);
+		if (HAL_GetTick() - tick < 10 && osSemaphoreTake(&never, OS_WAIT_FOREVER) == RTX_ERR) {
+			block_failed = 1;
+		}
+	}
+	if (slow_active) nested++;
+	fast_runs++;
+}
+
+void SlowJob(void *)
+{
+	volatile uint32_t locals[LOCALS];
+	for (int i = 0; i < LOCALS; i++) locals[i] = slow_runs * LOCALS + i;
+
+	slow_active = 1;
+	burn_ms(SLOW_BUSY_MS);
+	slow_active = 0;
+
+	for (int i = 0; i < LOCALS; i++) {
+		if (locals[i] != (uint32_t)(slow_runs * LOCALS + i)) corrupted++;
+	}
+	slow_runs++;
+}
+
+void Spinner(void *)
+{
+	while (1) {
+		burn_ms(1);
+		osSleep(4);
+	}
+}
+
+static void expect(int ok, const char* what)
+{
+	if (!ok) {
+		printf("FAIL: %s\r\n", what);
+		failures++;
+	}
+}
+
+static int near(int count, int expected)
+{
+	return count >= expected - expected / 10 - 1 && count <= expected + expected / 10 + 1;
+}
+
+void Checker(void *)
+{
+	osSleep(SLOW_PERIOD);
+	int fast_start = fast_runs, slow_start = slow_runs;
+	osSleep(MEASURE_MS);
+	int fast = fast_runs - fast_start, slow = slow_runs - slow_start;
+
+	printf("%d fast and %d slow releases in %d ms, %d nested\r\n", fast, slow, MEASURE_MS, nested);
+	expect(near(fast, MEASURE_MS / FAST_PERIOD), "fast job release count");
+	expect(near(slow, MEASURE_MS / SLOW_PERIOD), "slow job release count");
+	expect(nested > 0, "fast job never preempted the slow one");
+	expect(corrupted == 0, "slow job locals changed while it was preempted");
+	expect(block_failed, "a job could sleep or block");
+
+	TCB fast_info, slow_info;
+	osTaskInfo(1, &fast_info);
+	osTaskInfo(2, &slow_info);
+	expect(fast_info.stack_bot == slow_info.stack_bot, "jobs are not on the same stack");
+	printf("shared stack high water: %" PRIu32 " bytes\r\n", osTaskStackHighWater(1));
+
+	printf("%s\r\n", failures == 0 ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+  osSemaphoreInit(&never, 0);
+  void* probe = heap_probe();
+
+  TCB task;
+  task.ptask = &FastJob;
+  expect(osCreateJob(&task, FAST_PERIOD) == RTX_OK, "create fast job");
+  task.ptask = &SlowJob;
+  expect(osCreateJob(&task, SLOW_PERIOD) == RTX_OK, "create slow job");
+  expect(heap_probe() == probe, "job creation touched the heap");
+
+  task.stack_size = 0x400;
+  task.ptask = &Spinner;
+  osCreateDeadlineTask(5, &task);
+  task.ptask = &Checker;
+  osCreateDeadlineTask(50, &task);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,63 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_log.h"
+
+/*
+ * Target-side cost of KLOG against printf (both go through the DMA log ring).
+ *
+ * Capture the UART and run Tools/klog_decode.py on the ELF to see the KLOG
+ * lines; the summary printed with printf shows up as plain text.
+ */
+
+#define N 32
+
+void Logger(void *) {
+	uint32_t klog_total = 0, printf_total = 0;
+
+	for (uint32_t i = 0; i < N; i++) {
+		uint32_t start = DWT->CYCCNT;
+		KLOG("sample %lu: value 0x%08lx, task %u\r\n", i, i * 0x1234, osGetTID());
+		klog_total += DWT->CYCCNT - start;
+		osSleep(2);
+	}
+
+	for (uint32_t i = 0; i < N; i++) {
+		uint32_t start = DWT->CYCCNT;
+		printf("sample %lu: value 0x%08lx, task %u\r\n", i, i * 0x1234, osGetTID());
+		printf_total += DWT->CYCCNT - start;
+		osSleep(5);
+	}
+
+	printf("KLOG: %lu cycles per call, printf: %lu cycles per call\r\n",
+			klog_total / N, printf_total / N);
+	printf("%s\r\n", klog_total < printf_total ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Logger;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
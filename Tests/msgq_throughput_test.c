@@ -0,0 +1,104 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+#include "k_msgq.h"
+
+/*
+ * Messages per second between two tasks through zero-copy message queues.
+ *
+ * The producer owns a small pool of k_mem buffers. It stamps a buffer and
+ * sends it on data_q; the consumer reads the payload and returns the buffer
+ * on free_q, so buffer ownership goes producer -> consumer -> producer on
+ * every message. Because only the pointer moves, the rate should be the
+ * same for 16-byte and 1 KB payloads.
+ */
+
+#define POOL 4
+#define WINDOW_MS 1000
+
+k_msgq_t data_q;
+k_msgq_t free_q;
+volatile uint32_t checksum = 0;
+
+void Consumer(void *) {
+	void *msg;
+	while (1) {
+		osMsgQueueReceive(&data_q, &msg, OS_WAIT_FOREVER);
+		checksum += ((uint32_t *)msg)[0];
+		osMsgQueueSend(&free_q, msg, OS_WAIT_FOREVER);
+	}
+}
+
+static void run(uint32_t payload)
+{
+	void *msg;
+	uint32_t count = 0;
+
+	for (int i = 0; i < POOL; i++) {
+		msg = k_mem_alloc(payload);
+		((uint32_t *)msg)[0] = i;
+		osMsgQueueSend(&data_q, msg, OS_WAIT_FOREVER);
+	}
+
+	uint32_t start = HAL_GetTick();
+	while (HAL_GetTick() - start < WINDOW_MS) {
+		osMsgQueueReceive(&free_q, &msg, OS_WAIT_FOREVER);
+		((uint32_t *)msg)[0] = count++;
+		osMsgQueueSend(&data_q, msg, OS_WAIT_FOREVER);
+	}
+
+	// Collect the pool back; the producer owns every buffer again
+	int freed = 0;
+	while (freed < POOL && osMsgQueueReceive(&free_q, &msg, 10) == RTX_OK) {
+		if (k_mem_dealloc(msg) == RTX_OK) freed++;
+	}
+
+	printf("%4lu-byte payload: %lu messages/s, %d/%d buffers returned\r\n",
+			payload, count * 1000 / WINDOW_MS, freed, POOL);
+}
+
+void Producer(void *) {
+	if (osMsgQueueCreate(&data_q, POOL) != RTX_OK || osMsgQueueCreate(&free_q, POOL) != RTX_OK) {
+		printf("FAIL: could not create queues\r\n");
+		while (1);
+	}
+
+	TCB st_mytask;
+	st_mytask.stack_size = 0x400;
+	st_mytask.ptask = &Consumer;
+	osCreateTask(&st_mytask);
+
+	run(16);
+	run(1024);
+
+	printf("back to main\r\n");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Producer;
+  osCreateTask(&st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,165 @@
+#include "main.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+
+/*
+ * Classic priority inversion with EDF deadlines:
+ *   Low    (deadline 50) takes the bus mutex and holds it for ~3 ms.
+ *   High   (deadline 5)  wakes at t=1 ms and blocks on the mutex.
+ *   Medium (deadline 20) wakes at t=1 ms and burns ~10 ms of CPU.
+ *
+ * Without inheritance Medium runs before Low and High waits over 10 ms.
+ * With deadline inheritance Low takes High's deadline while High waits,
+ * finishes its critical section ahead of Medium, and High waits only for
+ * the rest of Low's critical section.
+ *
+ * Then Low sleeps while holding the mutex and High blocks on it meanwhile:
+ * when Low wakes it must still carry High's deadline, and after unlocking
+ * it must be back to at most its own.
+ *
+ * Finally Low exits holding bus and spare while High waits on bus. High must
+ * get bus, spare must be free, and Heir, created in Low's old slot, must not
+ * be able to unlock spare.
+ */
+
+k_mutex_t bus;
+k_mutex_t spare;
+volatile uint32_t high_wait = 0;
+volatile int medium_done = 0;
+volatile int high_before_medium = 0;
+volatile int phase2 = 0;
+volatile uint32_t held_left = 0, after_left = 0;
+volatile int high_relocked = 0;
+volatile int heir_unlock = -1;
+
+static void busy_ms(uint32_t ms)
+{
+	uint32_t start = HAL_GetTick();
+	while (HAL_GetTick() - start < ms);
+}
+
+void Low(void *) {
+	TCB self;
+	osMutexLock(&bus);
+	busy_ms(3);
+	osMutexUnlock(&bus);
+
+	while (!phase2) osSleep(1);
+	osMutexLock(&bus);
+	osSleep(3); // High blocks on the mutex meanwhile
+	osTaskInfo(osGetTID(), &self);
+	held_left = self.time_left;
+	osMutexUnlock(&bus);
+	osTaskInfo(osGetTID(), &self);
+	after_left = self.time_left;
+	phase2 = 2;
+
+	while (phase2 != 3) osSleep(1);
+	osMutexLock(&bus);
+	osMutexLock(&spare);
+	osSleep(3); // High blocks on bus meanwhile
+	osTaskExit(); // Still holding both
+}
+
+void Heir(void *) {
+	heir_unlock = osMutexUnlock(&spare);
+	while (1) osSleep(1000);
+}
+
+void Medium(void *) {
+	osSleep(1);
+	busy_ms(10);
+	medium_done = 1;
+
+	// High would never wake if Low's exit kept bus, so the verdict is here
+	while (phase2 != 3) osSleep(1);
+	osSleep(10);
+	TCB heir;
+	heir.stack_size = 0x400;
+	heir.ptask = &Heir;
+	osCreateDeadlineTask(50, &heir);
+	while (heir_unlock < 0) osSleep(1);
+	if (high_relocked && spare.owner == 0 && heir_unlock == RTX_ERR) {
+		printf("PASS: mutexes held at exit went to the waiter or were freed\r\n");
+	} else {
+		printf("FAIL: exit left mutexes owned (High got bus %d, spare owner 0x%" PRIx32 ", Heir unlock %d)\r\n",
+				high_relocked, spare.owner, heir_unlock);
+	}
+	while (1) osSleep(1000);
+}
+
+void High(void *) {
+	osSleep(1);
+
+	uint32_t start = HAL_GetTick();
+	if (osMutexLock(&bus) != RTX_OK) {
+		printf("FAIL: osMutexLock returned an error\r\n");
+	}
+	high_wait = HAL_GetTick() - start;
+	high_before_medium = !medium_done;
+	osMutexUnlock(&bus);
+
+	while (!medium_done) osSleep(5);
+	printf("High waited %" PRIu32 " ms for the mutex\r\n", high_wait);
+	if (high_before_medium && high_wait < 5) {
+		printf("PASS: Low inherited High's deadline and ran ahead of Medium\r\n");
+	} else {
+		printf("FAIL: priority inversion, Medium ran while High was blocked\r\n");
+	}
+
+	phase2 = 1;
+	osSleep(1);
+	osMutexLock(&bus);
+	osMutexUnlock(&bus);
+	while (phase2 != 2) osSleep(1);
+	printf("Low after sleeping with the mutex: time_left %" PRIu32 " held, %" PRIu32 " after unlock\r\n", held_left, after_left);
+	if (held_left <= 5 && after_left <= 50) {
+		printf("PASS: inheritance kept across the holder's sleep\r\n");
+	} else {
+		printf("FAIL: holder woke without the waiter's deadline or kept it after unlock\r\n");
+	}
+
+	phase2 = 3;
+	osSleep(1);
+	high_relocked = (osMutexLock(&bus) == RTX_OK);
+	osMutexUnlock(&bus);
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+  osMutexInit(&bus);
+  osMutexInit(&spare);
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+
+  st_mytask.ptask = &Low;
+  osCreateDeadlineTask(50, &st_mytask);
+
+  st_mytask.ptask = &Medium;
+  osCreateDeadlineTask(20, &st_mytask);
+
+  st_mytask.ptask = &High;
+  osCreateDeadlineTask(5, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,185 @@
+#include "main.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "common.h"
+#include "k_task.h"
+
+/*
+ * Periodic tasks with absolute release times.
+ *
+ * Control (10 ms period) and Logger (25 ms, deadline 20, phase 3) are busy
+ * for part of every job and record the tick each job starts at. Their starts
+ * must stay within a few ticks of the release grid for the whole run, never
+ * accumulating delay. Drifter does the same work as Control with
+ * osPeriodYield, which sleeps for whatever time_left remains, so any
+ * preemption or deadline reset shifts it; its drift is printed for
+ * comparison. The Checker then reads each task's job statistics.
+ *
+ * Early has a phase of 1 and main waits past it before osKernelStart, so its
+ * first release happens in the tick handler while no task is running yet.
+ */
+
+#define JOBS 40
+#define MAX_LAG 8   // ticks a job may start after its release (preempted by the others)
+
+typedef struct {
+	int period;
+	int deadline;
+	int busy_ms;
+	uint32_t starts[JOBS];
+	volatile int count;
+	task_t tid;
+} periodic_t;
+
+periodic_t control = { .period = 10, .deadline = 10, .busy_ms = 2 };
+periodic_t logger = { .period = 25, .deadline = 20, .busy_ms = 4 };
+periodic_t drifter = { .period = 10, .busy_ms = 2 };
+periodic_t early = { .period = 10, .deadline = 10 };
+uint32_t created;
+int failures = 0;
+
+static void burn_ms(uint32_t ms)
+{
+	uint32_t start = DWT->CYCCNT;
+	while (DWT->CYCCNT - start < ms * (SystemCoreClock / 1000));
+}
+
+static void job(periodic_t* p)
+{
+	if (p->count < JOBS) p->starts[p->count] = k_ticks;
+	p->count++;
+	burn_ms(p->busy_ms);
+}
+
+void Control(void *)
+{
+	while (1) {
+		job(&control);
+		osWaitNextPeriod();
+	}
+}
+
+void Logger(void *)
+{
+	while (1) {
+		job(&logger);
+		osWaitNextPeriod();
+	}
+}
+
+void Early(void *)
+{
+	while (1) {
+		job(&early);
+		osWaitNextPeriod();
+	}
+}
+
+void Drifter(void *)
+{
+	while (1) {
+		job(&drifter);
+		osPeriodYield();
+	}
+}
+
+static void expect(int ok, const char* what)
+{
+	if (!ok) {
+		printf("FAIL: %s\r\n", what);
+		failures++;
+	}
+}
+
+// Every start within MAX_LAG ticks of first_release + k * period
+static int on_grid(periodic_t* p, uint32_t first_release)
+{
+	for (int k = 0; k < JOBS; k++) {
+		uint32_t lag = p->starts[k] - (first_release + k * p->period);
+		if (lag > MAX_LAG) {
+			printf("job %d of task %u started %" PRId32 " ticks from its release\r\n", k, p->tid, (int32_t)lag);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void report(const char* name, periodic_t* p)
+{
+	k_period_t stats;
+	if (osPeriodStats(p->tid, &stats) != RTX_OK) {
+		expect(0, "osPeriodStats");
+		return;
+	}
+	uint32_t us = SystemCoreClock / 1000000;
+	printf("%s: %" PRIu32 " jobs, %" PRIu32 " missed, response last %" PRIu32 " us max %" PRIu32 " us, jitter max %" PRIu32 " us\r\n", name,
+			stats.jobs, stats.misses, stats.response_last / us, stats.response_max / us, stats.jitter_max / us);
+	expect(stats.jobs >= JOBS, "job count");
+	expect(stats.misses == 0, "deadline missed");
+	expect(stats.response_max / us <= (uint32_t)p->deadline * 1000, "response time above the deadline");
+	expect(stats.jitter_max / us < (uint32_t)p->deadline * 1000, "release jitter above the deadline");
+}
+
+void Checker(void *)
+{
+	while (control.count < JOBS || logger.count < JOBS || drifter.count < JOBS) osSleep(10);
+
+	expect(on_grid(&control, created), "Control drifted off its grid");
+	expect(on_grid(&logger, created + 3), "Logger drifted off its grid");
+	expect(early.count > 0, "task released before osKernelStart never ran");
+	report("Control", &control);
+	report("Logger", &logger);
+
+	int32_t drift = drifter.starts[JOBS - 1] - (drifter.starts[0] + (JOBS - 1) * drifter.period);
+	printf("osPeriodYield drift after %d jobs: %" PRId32 " ticks\r\n", JOBS, drift);
+	expect(osPeriodStats(drifter.tid, &(k_period_t){0}) == RTX_ERR, "stats of a task that is not periodic");
+	expect(osWaitNextPeriod() == RTX_ERR, "osWaitNextPeriod from a task that is not periodic");
+
+	printf("%s\r\n", failures == 0 ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB task;
+  task.stack_size = 0x400;
+  task.ptask = &Control;
+  expect(osCreatePeriodicTask(10, 20, 2, 0, &task) == RTX_ERR, "deadline after the period accepted");
+  expect(osCreatePeriodicTask(10, 10, 2, -1, &task) == RTX_ERR, "negative phase accepted");
+
+  task.ptask = &Early;
+  osCreatePeriodicTask(early.period, early.deadline, early.busy_ms, 1, &task);
+  early.tid = task.tid;
+  HAL_Delay(5); // Early is released here, before any task runs
+
+  task.ptask = &Control;
+  created = k_ticks;
+  osCreatePeriodicTask(control.period, control.deadline, control.busy_ms, 0, &task);
+  control.tid = task.tid;
+  task.ptask = &Logger;
+  osCreatePeriodicTask(logger.period, logger.deadline, logger.busy_ms, 3, &task);
+  logger.tid = task.tid;
+  task.ptask = &Drifter;
+  osCreateDeadlineTask(drifter.period, &task);
+  drifter.tid = task.tid;
+  task.ptask = &Checker;
+  osCreateDeadlineTask(100, &task);
+
+  osKernelStart();
+
+  while (1);
+}
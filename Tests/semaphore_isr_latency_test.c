@@ -0,0 +1,102 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+
+/*
+ * Interrupt-to-task wakeup latency through osSemaphoreGiveFromISR.
+ *
+ * The trigger task fires the B1 EXTI line in software (EXTI->SWIER), so the
+ * test needs no button presses. The ISR gives the semaphore and the worker,
+ * which has the earlier deadline and is blocked in osSemaphoreTake, records
+ * the cycles from the trigger to its first instruction after the take.
+ * The last check makes sure a take with a timeout gives up on time.
+ */
+
+#define N 100
+
+k_sem_t sem;
+volatile uint32_t t_trigger;
+uint32_t latency[N];
+volatile int n_latency = 0;
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if (GPIO_Pin == B1_Pin) {
+		osSemaphoreGiveFromISR(&sem);
+	}
+}
+
+void Worker(void *) {
+	while (1) {
+		osSemaphoreTake(&sem, OS_WAIT_FOREVER);
+		uint32_t now = DWT->CYCCNT;
+		if (n_latency < N) {
+			latency[n_latency++] = now - t_trigger;
+		}
+	}
+}
+
+void Trigger(void *) {
+	for (int i = 0; i < N; i++) {
+		osSleep(1);
+		t_trigger = DWT->CYCCNT;
+		EXTI->SWIER = B1_Pin;
+	}
+	while (n_latency < N) osSleep(1);
+
+	uint32_t min = 0xFFFFFFFF, max = 0, sum = 0;
+	for (int i = 0; i < N; i++) {
+		if (latency[i] < min) min = latency[i];
+		if (latency[i] > max) max = latency[i];
+		sum += latency[i];
+	}
+	printf("ISR -> task wakeup: min %lu, avg %lu, max %lu cycles\r\n", min, sum / N, max);
+
+	k_sem_t empty;
+	osSemaphoreInit(&empty, 0);
+	uint32_t start = HAL_GetTick();
+	int ret = osSemaphoreTake(&empty, 5);
+	uint32_t waited = HAL_GetTick() - start;
+	if (ret == RTX_ERR && waited >= 5 && waited <= 6) {
+		printf("PASS: take timed out after %lu ms\r\n", waited);
+	} else {
+		printf("FAIL: take returned %d after %lu ms\r\n", ret, waited);
+	}
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+  osSemaphoreInit(&sem, 0);
+
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, KERNEL_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+
+  st_mytask.ptask = &Worker;
+  osCreateDeadlineTask(2, &st_mytask);
+
+  st_mytask.ptask = &Trigger;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,101 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_sync.h"
+#include "k_ring.h"
+
+/*
+ * Throughput of the SPSC ring on target.
+ *
+ * 1. Raw put/get cost in one task, no contention.
+ * 2. ISR -> task streaming: the B1 EXTI line is fired in software and its
+ *    handler pushes a burst of samples with k_ring_put_notify. The consumer
+ *    blocks in k_ring_get_wait, so the semaphore is only given when the ring
+ *    goes from empty to non-empty, not once per sample.
+ */
+
+#define N 4096
+#define BURST 32
+#define BURSTS 200
+
+K_RING_DEFINE(ring, 256);
+k_sem_t ring_sem;
+volatile uint32_t next_sample = 0;
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	for (int i = 0; i < BURST; i++) {
+		k_ring_put_notify(&ring, next_sample++);
+	}
+}
+
+void Consumer(void *) {
+	uint32_t item, expected = 0, errors = 0;
+	uint32_t start = DWT->CYCCNT;
+	while (expected < BURST * BURSTS) {
+		k_ring_get_wait(&ring, &item, OS_WAIT_FOREVER);
+		if (item != expected) errors++;
+		expected++;
+	}
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	printf("ISR stream: %lu samples in %lu cycles, %lu errors\r\n", expected, cycles, errors);
+	printf("%s\r\n", errors ? "FAIL" : "PASS");
+	while (1) osSleep(1000);
+}
+
+void Producer(void *) {
+	// Raw cost: fill and drain the ring from one task
+	uint32_t item, sum = 0;
+	uint32_t start = DWT->CYCCNT;
+	for (int i = 0; i < N; i++) {
+		k_ring_put(&ring, i);
+		k_ring_get(&ring, &item);
+		sum += item;
+	}
+	uint32_t cycles = DWT->CYCCNT - start;
+	printf("put+get: %lu cycles per item (sum %lu)\r\n", cycles / N, sum);
+
+	TCB st_mytask;
+	st_mytask.stack_size = 0x400;
+	st_mytask.ptask = &Consumer;
+	osCreateDeadlineTask(2, &st_mytask);
+
+	for (int i = 0; i < BURSTS; i++) {
+		EXTI->SWIER = B1_Pin;
+		osSleep(1);
+	}
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+  osSemaphoreInit(&ring_sem, 0);
+  ring.notify = &ring_sem;
+
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, KERNEL_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Producer;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,79 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+
+/*
+ * The context save on a switch must still be checked by the outgoing task's
+ * own stack guard.
+ *
+ * Victim moves its stack pointer to OVERHANG bytes above the guard and spins
+ * there without touching the stack. When Preemptor wakes, SysTick stacks the
+ * 32-byte exception frame, which still fits, and PendSV then pushes R4-R11
+ * and LR, 36 bytes, which reach into the guard. The expected output is the
+ * MemManage report for Victim's TID. If PendSV has already moved the guard to
+ * Preemptor, the save silently lands in Victim's guard block and Victim
+ * later prints FAIL.
+ *
+ * Victim does no floating point, so the frame has no FP part.
+ */
+
+#define TEST_STACK_SIZE 0x400
+#define OVERHANG 40 // Above the usable bottom: frame fits, the PendSV save does not
+
+volatile int released = 0;
+
+void Preemptor(void *) {
+	osSleep(10);
+	released = 1;
+	while (1) osSleep(1000);
+}
+
+void Victim(void *) {
+	TCB self;
+	osTaskInfo(osGetTID(), &self);
+	uint32_t sp = stack_usable_bot(&self) + OVERHANG;
+
+	printf("Victim is task %u, expect a MemManage report for it\r\n", self.tid);
+	__asm volatile(
+		"mov r12, sp\n"
+		"mov sp, %0\n"
+		"1: ldr r1, [%1]\n"
+		"cmp r1, #0\n"
+		"beq 1b\n"
+		"mov sp, r12\n"
+		: : "r"(sp), "r"(&released) : "r1", "r12", "memory");
+
+	printf("FAIL: the context save below the guard did not fault\r\n");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB task;
+  task.stack_size = TEST_STACK_SIZE;
+
+  task.ptask = &Preemptor;
+  osCreateDeadlineTask(5, &task);
+
+  task.ptask = &Victim;
+  osCreateDeadlineTask(50, &task);
+
+  osKernelStart();
+
+  while (1);
+}
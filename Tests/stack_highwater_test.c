@@ -0,0 +1,93 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+
+/*
+ * TaskA uses almost no stack, TaskB fills its stack down to 3/4 of
+ * STACK_WARN_MARGIN above the usable bottom. The reporter prints each task's
+ * high watermark so stack_size can be right-sized, and checks that the null
+ * task flagged TaskB (which leaves less than STACK_WARN_MARGIN bytes) but not
+ * TaskA.
+ */
+
+#define TEST_STACK_SIZE 0x400
+#define LEAVE_BYTES (STACK_WARN_MARGIN * 3 / 4) // Room left for exception frames
+
+volatile int sink = 0;
+
+// Touches one array reaching from the current stack pointer down to
+// LEAVE_BYTES above bottom, whatever the compiler's frame sizes are
+static int __attribute__((noinline)) use_stack(uint32_t bottom)
+{
+	uint32_t size = __get_PSP() - (bottom + LEAVE_BYTES);
+	volatile uint8_t pad[size];
+	for (uint32_t i = 0; i < size; i++) pad[i] = (uint8_t)i;
+	return pad[0];
+}
+
+void TaskA(void *) {
+	while (1) {
+		sink++;
+		osSleep(5);
+	}
+}
+
+void TaskB(void *) {
+	TCB self;
+	osTaskInfo(osGetTID(), &self);
+	uint32_t bottom = stack_usable_bot(&self);
+
+	while (1) {
+		sink += use_stack(bottom);
+		osSleep(5);
+	}
+}
+
+void Reporter(void *) {
+	osSleep(STACK_CHECK_PERIOD * 3); // let the null task run a few checks
+
+	for (task_t tid = 1; tid <= 3; tid++) {
+		printf("task %u: high watermark %lu of %u bytes\r\n", tid,
+				osTaskStackHighWater(tid), TEST_STACK_SIZE);
+	}
+
+	uint32_t warnings = osGetStackWarnings();
+	int ok = (warnings & (1U << 2)) && !(warnings & (1U << 1));
+	printf("%s: stack warning mask 0x%lx\r\n", ok ? "PASS" : "FAIL", warnings);
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = TEST_STACK_SIZE;
+
+  st_mytask.ptask = &TaskA;
+  osCreateTask(&st_mytask);
+
+  st_mytask.ptask = &TaskB;
+  osCreateTask(&st_mytask);
+
+  st_mytask.ptask = &Reporter;
+  osCreateTask(&st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
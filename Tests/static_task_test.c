@@ -0,0 +1,103 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+
+/*
+ * Tasks created with osCreateTaskStatic on K_TASK_STACK buffers.
+ *
+ * main creates two workers and the checker on static stacks and verifies,
+ * with a probe allocation before and after, that creation did no heap work.
+ * The checker waits for the workers to exit, which must leave the heap alone
+ * as well, then creates a new worker on the first worker's buffer.
+ */
+
+#define WORKER_STACK 0x400
+
+K_TASK_STACK(stack_a, WORKER_STACK);
+K_TASK_STACK(stack_b, WORKER_STACK);
+K_TASK_STACK(stack_checker, WORKER_STACK);
+
+volatile int runs = 0;
+void* probe;
+int failures = 0;
+
+static void expect(int ok, const char* what)
+{
+	if (!ok) {
+		printf("FAIL: %s\r\n", what);
+		failures++;
+	}
+}
+
+// Allocates and frees a small block, returns where it landed
+static void* heap_probe(void)
+{
+	void* p = k_mem_alloc(8);
+	k_mem_dealloc(p);
+	return p;
+}
+
+void Worker(void *)
+{
+	runs++;
+	osTaskExit();
+}
+
+void Checker(void *)
+{
+	while (runs < 2) osSleep(1);
+	osSleep(1);
+
+	expect(heap_probe() == probe, "task exit touched the heap");
+
+	TCB task;
+	task.ptask = &Worker;
+	expect(osCreateTaskStatic(&task, stack_a, sizeof(stack_a), 1, 0) == RTX_OK, "re-create on a freed static stack");
+	expect(runs == 3, "re-created worker did not run");
+	expect(task.stack_bot == (uint32_t)(uintptr_t)stack_a, "re-created worker is not on its buffer");
+	osSleep(1);
+	expect(heap_probe() == probe, "re-created worker touched the heap");
+
+	printf("%s\r\n", failures == 0 ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+  probe = heap_probe();
+
+  TCB task;
+  task.ptask = &Worker;
+  expect(osCreateTaskStatic(&task, (uint8_t*)stack_a + 4, WORKER_STACK - 8, 5, 0) == RTX_ERR, "misaligned stack accepted");
+  expect(osCreateTaskStatic(&task, stack_a, WORKER_STACK - 4, 5, 0) == RTX_ERR, "odd stack size accepted");
+  expect(osCreateTaskStatic(&task, stack_a, MIN_STACK_SIZE / 2, 5, 0) == RTX_ERR, "undersized stack accepted");
+  expect(osCreateTaskStatic(&task, NULL, WORKER_STACK, 5, 0) == RTX_ERR, "NULL stack accepted");
+
+  expect(osCreateTaskStatic(&task, stack_a, sizeof(stack_a), 5, 0) == RTX_OK, "create on stack_a");
+  expect(task.stack_bot == (uint32_t)(uintptr_t)stack_a && task.stack_size == sizeof(stack_a), "worker A is not on its buffer");
+  expect(osCreateTaskStatic(&task, stack_b, sizeof(stack_b), 5, 0) == RTX_OK, "create on stack_b");
+
+  task.ptask = &Checker;
+  expect(osCreateTaskStatic(&task, stack_checker, sizeof(stack_checker), 10, 0) == RTX_OK, "create checker");
+
+  expect(heap_probe() == probe, "task creation touched the heap");
+
+  osKernelStart();
+
+  while (1);
+}
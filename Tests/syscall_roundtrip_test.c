@@ -0,0 +1,76 @@
+#include "main.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "common.h"
+#include "k_task.h"
+
+/*
+ * System call round trip: SVC entry, table dispatch, and the result written
+ * back through the stacked r0. osSyscallPing does no work in the kernel, so
+ * its cost is the syscall overhead alone. Task creation, which used to return
+ * through the SVC_RET global, is checked for both results.
+ */
+
+#define N 1000
+
+void Child(void *) {
+	osTaskExit();
+}
+
+void Bench(void *) {
+	int pass = 1;
+	uint32_t min = 0xFFFFFFFF, max = 0, total = 0;
+
+	for (int i = 0; i < N; i++) {
+		uint32_t start = DWT->CYCCNT;
+		int ret = osSyscallPing(i);
+		uint32_t cycles = DWT->CYCCNT - start;
+		if (ret != i + 1) pass = 0;
+		if (cycles < min) min = cycles;
+		if (cycles > max) max = cycles;
+		total += cycles;
+	}
+	printf("syscall round trip: min %" PRIu32 " avg %" PRIu32 " max %" PRIu32 " cycles\r\n", min, total / N, max);
+
+	TCB st_mytask;
+	st_mytask.stack_size = 0x400;
+	st_mytask.ptask = &Child;
+	if (osCreateDeadlineTask(50, &st_mytask) != RTX_OK) {
+		printf("create returned an error\r\n");
+		pass = 0;
+	}
+	st_mytask.stack_size = 0; // stack allocation fails inside the kernel
+	if (osCreateDeadlineTask(50, &st_mytask) != RTX_ERR) {
+		printf("failed create did not return RTX_ERR\r\n");
+		pass = 0;
+	}
+
+	printf("%s\r\n", pass ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Bench;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
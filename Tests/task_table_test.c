@@ -0,0 +1,119 @@
+#include "main.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_mem.h"
+
+/*
+ * Startup through the K_TASK_DEFINE table.
+ *
+ * TABLE_TASKS tasks are declared at compile time; osKernelInit builds their
+ * stacks and queues them without a system call or heap allocation. For
+ * comparison, main then creates DYN_TASKS more of the same size through
+ * osCreateDeadlineTask. The First task has the earliest deadline and records
+ * the cycle count when it starts.
+ *
+ * DWT is started at the top of main, before the HAL and clock setup, and
+ * osKernelInit restarts it, so main to first task is the sum of the two spans,
+ * less the time spent on the DYN_TASKS comparison creations in between.
+ * The startup code before main (.data/.bss init, SystemInit) is not included;
+ * it does not depend on the number of tasks. The timings are reported, the
+ * verdict only checks that every task was created and ran.
+ */
+
+#define TASK_STACK 0x200
+#define TABLE_TASKS 6
+#define DYN_TASKS 6
+
+volatile uint32_t first_stamp;
+volatile int table_runs = 0;
+volatile int dyn_runs = 0;
+
+void First(void *);
+void TableTask(void *);
+
+K_TASK_DEFINE(first_tid, First, TASK_STACK, 1);
+K_TASK_DEFINE(table_1, TableTask, TASK_STACK, 5);
+K_TASK_DEFINE(table_2, TableTask, TASK_STACK, 5);
+K_TASK_DEFINE(table_3, TableTask, TASK_STACK, 5);
+K_TASK_DEFINE(table_4, TableTask, TASK_STACK, 5);
+K_TASK_DEFINE(table_5, TableTask, TASK_STACK, 5);
+
+uint32_t pre_init, init_cycles, dyn_cycles;
+
+void TableTask(void *)
+{
+	table_runs++;
+	osTaskExit();
+}
+
+void DynTask(void *)
+{
+	dyn_runs++;
+	osTaskExit();
+}
+
+void First(void *)
+{
+	first_stamp = DWT->CYCCNT;
+	osSleep(10); // Let every other task run and exit
+
+	int ok = 1;
+	task_t tids[] = { first_tid, table_1, table_2, table_3, table_4, table_5 };
+	for (int i = 0; i < TABLE_TASKS; i++) {
+		if (tids[i] == TID_INVALID || tids[i] == TID_NULL) ok = 0;
+		for (int j = 0; j < i; j++) {
+			if (tids[i] == tids[j]) ok = 0;
+		}
+	}
+	if (!ok) printf("FAIL: table tasks did not get distinct TIDs\r\n");
+	if (table_runs != TABLE_TASKS - 1 || dyn_runs != DYN_TASKS) {
+		printf("FAIL: %d table and %d dynamic tasks ran\r\n", table_runs, dyn_runs);
+		ok = 0;
+	}
+
+	uint32_t total = pre_init + first_stamp - dyn_cycles;
+	printf("osKernelInit with %d table tasks: %" PRIu32 " cycles\r\n", TABLE_TASKS, init_cycles);
+	printf("osCreateDeadlineTask: %" PRIu32 " cycles per task\r\n", dyn_cycles / DYN_TASKS);
+	printf("main to first task: %" PRIu32 " cycles (%" PRIu32 " us)\r\n", total, total / (SystemCoreClock / 1000000));
+
+	printf("%s\r\n", ok ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  pre_init = DWT->CYCCNT;
+  osKernelInit(); // Restarts DWT->CYCCNT
+  init_cycles = DWT->CYCCNT;
+
+  TCB task;
+  task.stack_size = TASK_STACK;
+  task.ptask = &DynTask;
+  uint32_t start = DWT->CYCCNT;
+  for (int i = 0; i < DYN_TASKS; i++) {
+	  osCreateDeadlineTask(5, &task);
+  }
+  dyn_cycles = DWT->CYCCNT - start;
+
+  osKernelStart();
+
+  while (1);
+}
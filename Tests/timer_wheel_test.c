@@ -0,0 +1,102 @@
+#include "main.h"
+#include <stdio.h>
+#include <inttypes.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_timer.h"
+
+/*
+ * Software timers on the timer wheel.
+ *
+ * 50 auto-reload timers with periods 10..59 ms (several share wheel slots and
+ * some span more than one turn of the wheel) plus one one-shot. After 1200 ms
+ * every timer must have fired floor(1200 / period) times, give or take one
+ * for the expiry in flight. Also prints start/stop cost and the RAM used
+ * compared with one 0x400-stack task per periodic job.
+ */
+
+#define N_TIMERS 50
+#define RUN_MS 1200
+
+k_timer_t timers[N_TIMERS];
+k_timer_t oneshot;
+volatile uint32_t fired[N_TIMERS];
+volatile uint32_t oneshot_fired = 0;
+
+void Tick(void* arg) {
+	fired[(uintptr_t)arg]++;
+}
+
+void OneShot(void* arg) {
+	oneshot_fired++;
+}
+
+void Controller(void *) {
+	int pass = 1;
+
+	for (uint32_t i = 0; i < N_TIMERS; i++) {
+		osTimerCreate(&timers[i], &Tick, (void*)(uintptr_t)i);
+	}
+	osTimerCreate(&oneshot, &OneShot, NULL);
+
+	uint32_t start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < N_TIMERS; i++) {
+		osTimerStart(&timers[i], 10 + i, 10 + i);
+	}
+	uint32_t start_cycles = (DWT->CYCCNT - start) / N_TIMERS;
+	osTimerStart(&oneshot, 100, 0);
+
+	osSleep(RUN_MS);
+
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < N_TIMERS; i++) {
+		osTimerStop(&timers[i]);
+	}
+	uint32_t stop_cycles = (DWT->CYCCNT - start) / N_TIMERS;
+
+	for (uint32_t i = 0; i < N_TIMERS; i++) {
+		uint32_t expected = RUN_MS / (10 + i);
+		if (fired[i] + 1 < expected || fired[i] > expected + 1) {
+			printf("timer %" PRIu32 ": %" PRIu32 " expiries, expected %" PRIu32 "\r\n", i, fired[i], expected);
+			pass = 0;
+		}
+	}
+	if (oneshot_fired != 1 || osTimerIsActive(&oneshot)) {
+		printf("one-shot fired %" PRIu32 " times\r\n", oneshot_fired);
+		pass = 0;
+	}
+
+	printf("start %" PRIu32 " cycles, stop %" PRIu32 " cycles\r\n", start_cycles, stop_cycles);
+	printf("RAM for %d timers: %zu bytes (daemon %zu + timers %zu)\r\n", N_TIMERS,
+			TIMER_DAEMON_STACK + sizeof(TCB) + N_TIMERS * sizeof(k_timer_t),
+			TIMER_DAEMON_STACK + sizeof(TCB), N_TIMERS * sizeof(k_timer_t));
+	printf("RAM as tasks: %zu bytes\r\n", N_TIMERS * (THREAD_STACK_SIZE + sizeof(TCB)));
+	printf("%s\r\n", pass ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Controller;
+  osCreateDeadlineTask(20, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,78 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+#include "k_trace.h"
+
+/*
+ * Kernel tracer cost and a sample schedule. Build with TRACE_ENABLE 1.
+ *
+ * Measures cycles per trace record (target: under 20), then runs two
+ * periodic tasks for a while, stops the trace and prints how to dump it.
+ */
+
+#define N 1000
+
+void Worker(void *) {
+	while (1) {
+		for (volatile int i = 0; i < 2000; i++);
+		osPeriodYield();
+	}
+}
+
+void Controller(void *) {
+#if TRACE_ENABLE
+	uint32_t start = DWT->CYCCNT;
+	for (int i = 0; i < N; i++) {
+		K_TRACE(K_TRACE_USER, osGetTID(), i);
+	}
+	uint32_t empty = DWT->CYCCNT;
+	for (int i = 0; i < N; i++) {
+		osGetTID();
+	}
+	uint32_t end = DWT->CYCCNT;
+	uint32_t cycles = ((empty - start) - (end - empty)) / N;
+	printf("trace record: %lu cycles\r\n", cycles);
+
+	osTraceStart();
+	osSleep(50);
+	osTraceStop();
+
+	printf("%lu records, dump with: dump binary value trace.bin k_trace\r\n", k_trace.count);
+	printf("%s\r\n", cycles < 20 ? "PASS" : "FAIL");
+#else
+	printf("TRACE_ENABLE is 0, rebuild with the tracer on\r\n");
+	printf("FAIL\r\n");
+#endif
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Controller;
+  osCreateDeadlineTask(100, &st_mytask);
+
+  st_mytask.ptask = &Worker;
+  osCreateDeadlineTask(4, &st_mytask);
+  osCreateDeadlineTask(7, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
@@ -0,0 +1,77 @@
+#include "main.h"
+#include <stdio.h>
+#include "common.h"
+#include "k_task.h"
+
+/*
+ * printf latency with the DMA log ring (LOG_ASYNC).
+ *
+ * Times a 40-character printf through the ring, then the same line sent the
+ * old way with a blocking HAL_UART_Transmit. A burst larger than the ring at
+ * the end checks that overflow drops bytes and counts them instead of
+ * blocking.
+ */
+
+#define N 20
+#define LINE "0123456789 abcdefghijklmnopqrstuvwxyz\r\n"
+
+extern UART_HandleTypeDef huart2;
+
+void Logger(void *) {
+	uint32_t min = 0xFFFFFFFF, max = 0, total = 0;
+	for (int i = 0; i < N; i++) {
+		uint32_t start = DWT->CYCCNT;
+		printf(LINE);
+		uint32_t cycles = DWT->CYCCNT - start;
+		if (cycles < min) min = cycles;
+		if (cycles > max) max = cycles;
+		total += cycles;
+		osSleep(5); // let DMA drain so the ring never fills here
+	}
+	osSleep(50);
+	printf("async printf: min %lu avg %lu max %lu cycles\r\n", min, total / N, max);
+	osSleep(50);
+
+	uint32_t start = DWT->CYCCNT;
+	HAL_UART_Transmit(&huart2, (uint8_t*)LINE, sizeof(LINE) - 1, HAL_MAX_DELAY);
+	uint32_t blocking = DWT->CYCCNT - start;
+	printf("blocking transmit: %lu cycles\r\n", blocking);
+	osSleep(50);
+
+	uint32_t dropped = log_dropped_count();
+	for (int i = 0; i < 2 * LOG_BUF_SIZE / (sizeof(LINE) - 1); i++) {
+		printf(LINE);
+	}
+	dropped = log_dropped_count() - dropped;
+	osSleep(200);
+	printf("overflow burst: %lu bytes dropped\r\n", dropped);
+
+	printf("%s\r\n", (max < blocking && dropped > 0) ? "PASS" : "FAIL");
+	while (1) osSleep(1000);
+}
+
+int main(void)
+{
+  /* MCU Configuration: Don't change this or the whole chip won't work!*/
+
+  /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
+  HAL_Init();
+  /* Configure the system clock */
+  SystemClock_Config();
+
+  /* Initialize all configured peripherals */
+  MX_GPIO_Init();
+  MX_USART2_UART_Init();
+  /* MCU Configuration is now complete. Start writing your code below this line */
+
+  osKernelInit();
+
+  TCB st_mytask;
+  st_mytask.stack_size = 0x400;
+  st_mytask.ptask = &Logger;
+  osCreateDeadlineTask(10, &st_mytask);
+
+  osKernelStart();
+
+  while (1);
+}
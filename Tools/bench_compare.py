@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""Compare two benchmark captures from Tests/bench.
+
+Usage:
+    bench_compare.py baseline.csv current.csv [--threshold 10]
+
+Each capture is the raw UART (or host) output: lines starting with '#' and
+anything that is not a CSV row of bench.h's format are ignored. Prints the
+median and p99 of every benchmark present in both captures, and exits with
+status 1 if any median got slower by more than the threshold (percent) or a
+benchmark of the baseline is missing from the current capture.
+"""
+
+import argparse
+import csv
+import sys
+
+FIELDS = ["bench", "unit", "n", "min", "median", "p99", "max"]
+
+
+def load(path):
+    rows = {}
+    with open(path, newline="") as f:
+        for row in csv.reader(line.strip() for line in f):
+            if len(row) != len(FIELDS) or row[0].startswith("#") or row[0] == "bench":
+                continue
+            try:
+                rows[row[0]] = dict(zip(FIELDS[2:], map(int, row[2:])), unit=row[1])
+            except ValueError:
+                continue
+    return rows
+
+
+def change(old, new):
+    return 100.0 * (new - old) / old if old else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="median slowdown in percent that counts as a regression")
+    args = parser.parse_args()
+
+    old, new = load(args.baseline), load(args.current)
+    regressions = 0
+    print("%-20s %12s %12s %8s %12s %12s %8s" % ("bench", "median", "was", "", "p99", "was", ""))
+    for name in sorted(old.keys() & new.keys()):
+        o, n = old[name], new[name]
+        dm, dp = change(o["median"], n["median"]), change(o["p99"], n["p99"])
+        flag = ""
+        if dm > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("%-20s %12d %12d %+7.1f%% %12d %12d %+7.1f%%%s"
+              % (name, n["median"], o["median"], dm, n["p99"], o["p99"], dp, flag))
+
+    missing = sorted(old.keys() - new.keys())
+    for name in missing:
+        print("%-20s missing from %s  REGRESSION" % (name, args.current))
+    sys.exit(1 if regressions or missing else 0)
+
+
+if __name__ == "__main__":
+    main()
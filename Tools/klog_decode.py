@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Decode KLOG binary records from the UART byte stream.
+
+Usage:
+    klog_decode.py firmware.elf capture.bin [--clock HZ]
+    cat /dev/ttyACM0 | klog_decode.py firmware.elf -
+
+Format strings are read from the .klog_fmt section of the ELF. Bytes that are
+not part of a record (ordinary printf output) are passed through unchanged.
+Record layout is described in Core/Inc/k_log.h.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+KLOG_SYNC = 0xA5
+KLOG_MAX_ARGS = 6
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|t)?([diouxXcp%])")
+
+
+def read_klog_section(path):
+    """Return the bytes of .klog_fmt from a 32-bit little-endian ELF."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        sys.exit("%s: not a 32-bit ELF" % path)
+
+    e_shoff, = struct.unpack_from("<I", elf, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def section(i):
+        # name, type, flags, addr, offset, size
+        return struct.unpack_from("<IIIIII", elf, e_shoff + i * e_shentsize)
+
+    strtab = section(e_shstrndx)
+    for i in range(e_shnum):
+        name, _, _, _, offset, size = section(i)
+        start = strtab[4] + name
+        if elf[start:elf.index(b"\0", start)] == b".klog_fmt":
+            return elf[offset:offset + size]
+    sys.exit("%s: no .klog_fmt section" % path)
+
+
+def format_record(fmt, args):
+    """Apply a C format string to 32-bit arguments."""
+    args = list(args)
+
+    def convert(m):
+        flags, conv = m.group(1), m.group(2)
+        if conv == "%":
+            return "%"
+        value = args.pop(0) if args else 0
+        if conv in "di":
+            value = struct.unpack("<i", struct.pack("<I", value))[0]
+            conv = "d"
+        elif conv == "u":
+            conv = "d"
+        elif conv == "p":
+            return "0x%08x" % value
+        elif conv == "c":
+            return chr(value & 0xFF)
+        return ("%" + flags + conv) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode_buffer(strings, data, out, clock, final):
+    """Decode what is complete in data, return the index of the first byte not consumed.
+
+    A record cut off at the end of data is left for the next read, unless final.
+    """
+    i = 0
+    while i < len(data):
+        if data[i] == KLOG_SYNC:
+            complete = i + 8 <= len(data)
+            if complete:
+                header, cycles = struct.unpack_from("<II", data, i)
+                nargs = (header >> 8) & 0xFF
+                offset = header >> 16
+                end = i + 8 + 4 * nargs
+                valid = nargs <= KLOG_MAX_ARGS and offset < len(strings)
+                complete = not valid or end <= len(data)
+            if not complete and not final:
+                break
+            if complete and valid:
+                args = struct.unpack_from("<%dI" % nargs, data, i + 8)
+                fmt = strings[offset:strings.index(b"\0", offset)].decode("ascii", "replace")
+                out.write("[%12.3f us] %s" % (cycles * 1e6 / clock, format_record(fmt, args)))
+                i = end
+                continue
+
+        # Ordinary text, or a sync byte that does not start a record
+        out.write(chr(data[i]))
+        i += 1
+    return i
+
+
+def decode(strings, stream, out, clock):
+    """Decode as bytes arrive, so a live serial port is shown as it goes."""
+    pending = b""
+    while True:
+        chunk = stream.read1(4096)
+        pending += chunk
+        used = decode_buffer(strings, pending, out, clock, final=not chunk)
+        pending = pending[used:]
+        out.flush()
+        if not chunk:
+            break
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF with the .klog_fmt section")
+    parser.add_argument("capture", help="raw UART capture, - for stdin")
+    parser.add_argument("--clock", type=float, default=84e6,
+                        help="core clock in Hz for DWT timestamps (default 84 MHz)")
+    args = parser.parse_args()
+
+    strings = read_klog_section(args.elf)
+    if args.capture == "-":
+        decode(strings, sys.stdin.buffer, sys.stdout, args.clock)
+    else:
+        with open(args.capture, "rb") as f:
+            decode(strings, f, sys.stdout, args.clock)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Convert a k_trace dump to Chrome trace JSON.
+
+Usage:
+    (gdb) dump binary value trace.bin k_trace
+    trace_to_chrome.py trace.bin > trace.json
+
+Open the result in chrome://tracing or https://ui.perfetto.dev. Each task
+gets its own row showing when it ran. Kernel events (SVCs, ticks, ready queue
+operations) are instant markers, and interrupts appear on an "ISR" row.
+Layout of the dump is k_trace_t in Core/Inc/k_trace.h. SVC names are read
+from the SVC_* defines in Core/Inc/k_task.h (--header to point elsewhere).
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+K_TRACE_MAGIC = 0x45435254
+HEADER = struct.Struct("<IIIII")   # magic, count, size, clock, enabled
+RECORD = struct.Struct("<IBBH")    # stamp, type, tid, arg
+
+SWITCH, SVC, TICK, READY, POP, ISR_ENTER, ISR_EXIT, USER = range(1, 9)
+ISR_ROW = 1000
+ARG_MAX = 0xFFFF                   # K_TRACE_ARG_MAX, READY's time_left is clamped to it
+
+HEADER_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           "..", "Core", "Inc", "k_task.h")
+
+
+def svc_names(path):
+    """SVC number to name, from the "#define SVC_<NAME> <number>" lines."""
+    names = {}
+    try:
+        with open(path) as f:
+            for line in f:
+                m = re.match(r"#define\s+SVC_(\w+)\s+(\d+)\b", line)
+                if m and m.group(1) != "COUNT":
+                    names[int(m.group(2))] = m.group(1)
+    except OSError as e:
+        print("%s, SVCs are shown by number" % e, file=sys.stderr)
+    return names
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, count, size, clock, _ = HEADER.unpack_from(data, 0)
+    if magic != K_TRACE_MAGIC:
+        sys.exit("%s: not a k_trace dump (magic 0x%08x)" % (path, magic))
+
+    records = [RECORD.unpack_from(data, HEADER.size + i * RECORD.size) for i in range(size)]
+
+    # Oldest record first; once the ring has wrapped it starts at count % size
+    if count > size:
+        start = count % size
+        records = records[start:] + records[:start]
+    else:
+        records = records[:count]
+    return records, clock or 84000000
+
+
+def convert(records, clock, svc_names):
+    events = []
+    base = None
+    last = 0
+    high = 0
+    running = None          # (tid, start_us)
+
+    for stamp, kind, tid, arg in records:
+        # Unwrap the 32-bit cycle counter
+        if base is None:
+            base = stamp
+        if stamp < last:
+            high += 1 << 32
+        last = stamp
+        ts = (high + stamp - base) * 1e6 / clock
+
+        if kind == SWITCH:
+            if running is not None:
+                events.append({"name": "task %d" % running[0], "ph": "X", "pid": 1,
+                               "tid": running[0], "ts": running[1], "dur": ts - running[1]})
+            running = (arg, ts)
+        elif kind == SVC:
+            events.append({"name": "SVC " + svc_names.get(arg, str(arg)), "ph": "i",
+                           "s": "t", "pid": 1, "tid": tid, "ts": ts})
+        elif kind == TICK:
+            events.append({"name": "tick", "ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts})
+        elif kind == READY:
+            events.append({"name": "ready", "ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts,
+                           "args": {"time_left": arg if arg < ARG_MAX else ">= %d" % ARG_MAX}})
+        elif kind == POP:
+            events.append({"name": "pop", "ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts,
+                           "args": {"queued": arg}})
+        elif kind == ISR_ENTER:
+            events.append({"name": "IRQ %d" % (arg - 16), "ph": "B", "pid": 1, "tid": ISR_ROW, "ts": ts})
+        elif kind == ISR_EXIT:
+            events.append({"name": "IRQ %d" % (arg - 16), "ph": "E", "pid": 1, "tid": ISR_ROW, "ts": ts})
+        elif kind == USER:
+            events.append({"name": "user", "ph": "i", "s": "t", "pid": 1, "tid": tid, "ts": ts,
+                           "args": {"arg": arg}})
+
+    if running is not None:
+        events.append({"name": "task %d" % running[0], "ph": "X", "pid": 1,
+                       "tid": running[0], "ts": running[1], "dur": ts - running[1]})
+
+    tids = sorted({e["tid"] for e in events})
+    for tid in tids:
+        name = "ISR" if tid == ISR_ROW else ("null task" if tid == 0 else "task %d" % tid)
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}})
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", help="binary dump of k_trace")
+    parser.add_argument("--header", default=HEADER_PATH, help="k_task.h with the SVC_* numbers")
+    args = parser.parse_args()
+
+    records, clock = load(args.dump)
+    json.dump(convert(records, clock, svc_names(args.header)), sys.stdout, indent=1)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()